@@ -0,0 +1,16 @@
+@echo off
+setlocal
+chcp 65001
+
+rem Build the C++ library with optimizations
+cmake -B build_benchmark -D JAVABIND_INTEGER_SIGNED_CAST=ON
+if errorlevel 1 exit /b %ERRORLEVEL%
+cmake --build build_benchmark --config Release --target javabind_benchmark javabind_embedded_benchmark
+if errorlevel 1 exit /b %ERRORLEVEL%
+
+rem Compile and run the Java benchmark application
+dir /s /b java\*.java > build_benchmark\sources.txt
+javac -d jar -cp java @build_benchmark\sources.txt
+if errorlevel 1 exit /b %ERRORLEVEL%
+java -Djava.library.path=build_benchmark\Release -cp jar hu.info.hunyadi.benchmark.Benchmark %*
+if errorlevel 1 exit /b %ERRORLEVEL%
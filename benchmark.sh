@@ -0,0 +1,11 @@
+set -e
+
+# Build the C++ library with optimizations
+cmake -B build_benchmark -D CMAKE_BUILD_TYPE=Release -D JAVABIND_INTEGER_SIGNED_CAST=ON
+cmake --build build_benchmark --target javabind_benchmark javabind_embedded_benchmark
+
+# Compile and run the Java benchmark application
+find java -name "*.java" > build_benchmark/sources.txt
+mkdir -p jar
+javac -d jar -cp java @build_benchmark/sources.txt
+java -Djava.library.path=build_benchmark -cp jar hu.info.hunyadi.benchmark.Benchmark "$@"
@@ -0,0 +1,289 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#include <javabind/javabind.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Number of native heap allocations made on the current thread by code compiled into this module, including
+ * the type converters of javabind, which are instantiated here.
+ *
+ * Allocations made inside the C++ standard library shared object or the Java VM are not counted.
+ */
+static thread_local std::uint64_t allocation_count = 0;
+
+void* operator new(std::size_t size)
+{
+    ++allocation_count;
+    if (void* ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct Point
+{
+    double x = 0.0;
+    double y = 0.0;
+};
+
+enum class Color
+{
+    Red,
+    Green,
+    Blue
+};
+
+/**
+ * A native object whose lifecycle and member function calls are measured.
+ */
+struct Counter
+{
+    int64_t value() const
+    {
+        return _value;
+    }
+
+    void add(int32_t val)
+    {
+        _value += val;
+    }
+
+private:
+    int64_t _value = 0;
+};
+
+/**
+ * Holds the last value received from Java, which is sent back to Java on request.
+ */
+template <typename T>
+struct Slot
+{
+    inline static T value{};
+};
+
+/**
+ * Functions that do (almost) nothing, such that the time of a call is dominated by marshalling arguments and
+ * results between Java and C++.
+ */
+struct Marshalling
+{
+    static int64_t native_allocations()
+    {
+        return static_cast<int64_t>(allocation_count);
+    }
+
+    /** Converts a Java value into a native value (Java to C++ direction). */
+    template <typename T>
+    static void accept(T value)
+    {
+        Slot<T>::value = std::move(value);
+    }
+
+    /** Converts a native value into a Java value (C++ to Java direction). */
+    template <typename T>
+    static T result()
+    {
+        return Slot<T>::value;
+    }
+
+    /** Views are not copied, only their length is read. */
+    template <typename V>
+    static int64_t accept_view(const V& value)
+    {
+        return static_cast<int64_t>(value.size());
+    }
+
+    /** Calls a Java functional interface from C++ once. */
+    template <typename R, typename T>
+    static R invoke(const std::function<R(T)>& fn, T arg)
+    {
+        return fn(std::move(arg));
+    }
+
+    static std::function<bool(int32_t)> get_int_predicate()
+    {
+        return [](int32_t value) { return value % 2 == 0; };
+    }
+
+    static std::function<void(int32_t)> get_int_consumer()
+    {
+        return [](int32_t value) { Slot<int32_t>::value = value; };
+    }
+
+    static std::function<std::string(std::string)> get_function()
+    {
+        return [](std::string value) { return value; };
+    }
+
+    static std::function<int32_t(std::string)> get_to_int_function()
+    {
+        return [](std::string value) { return static_cast<int32_t>(value.size()); };
+    }
+
+    static javabind::stream<int32_t> get_int_stream(int32_t count)
+    {
+        std::vector<int32_t> values(static_cast<std::size_t>(count));
+        std::iota(values.begin(), values.end(), 0);
+        return javabind::make_stream(std::move(values), 1024);
+    }
+};
+
+DECLARE_RECORD_CLASS(Point, "hu.info.hunyadi.benchmark.Point");
+DECLARE_ENUM_CLASS(Color, "hu.info.hunyadi.benchmark.Color");
+DECLARE_NATIVE_CLASS(Counter, "hu.info.hunyadi.benchmark.Counter");
+DECLARE_STATIC_CLASS(Marshalling, "hu.info.hunyadi.benchmark.Marshalling");
+
+JAVA_EXTENSION_MODULE()
+{
+    using namespace javabind;
+
+    record_class<Point>()
+        .field<&Point::x>("x")
+        .field<&Point::y>("y")
+        ;
+
+    enum_class<Color>()
+        .value(Color::Red, "Red")
+        .value(Color::Green, "Green")
+        .value(Color::Blue, "Blue")
+        ;
+
+    native_class<Counter>()
+        .constructor<Counter()>("create")
+        .function<&Counter::add>("add")
+        .function<&Counter::value>("value")
+        ;
+
+    static_class<Marshalling>()
+        .function<Marshalling::native_allocations>("native_allocations")
+
+        // primitive types
+        .function<Marshalling::accept<bool>>("accept_boolean")
+        .function<Marshalling::result<bool>>("result_boolean")
+        .function<Marshalling::accept<int8_t>>("accept_byte")
+        .function<Marshalling::result<int8_t>>("result_byte")
+        .function<Marshalling::accept<char16_t>>("accept_char")
+        .function<Marshalling::result<char16_t>>("result_char")
+        .function<Marshalling::accept<int16_t>>("accept_short")
+        .function<Marshalling::result<int16_t>>("result_short")
+        .function<Marshalling::accept<int32_t>>("accept_int")
+        .function<Marshalling::result<int32_t>>("result_int")
+        .function<Marshalling::accept<int64_t>>("accept_long")
+        .function<Marshalling::result<int64_t>>("result_long")
+        .function<Marshalling::accept<float>>("accept_float")
+        .function<Marshalling::result<float>>("result_float")
+        .function<Marshalling::accept<double>>("accept_double")
+        .function<Marshalling::result<double>>("result_double")
+
+        // boxed types
+        .function<Marshalling::accept<boxed<int32_t>>>("accept_boxed_integer")
+        .function<Marshalling::result<boxed<int32_t>>>("result_boxed_integer")
+        .function<Marshalling::accept<boxed<double>>>("accept_boxed_double")
+        .function<Marshalling::result<boxed<double>>>("result_boxed_double")
+
+        // strings
+        .function<Marshalling::accept<std::string>>("accept_string")
+        .function<Marshalling::result<std::string>>("result_string")
+        .function<Marshalling::accept_view<std::string_view>>("accept_string_view")
+        .function<Marshalling::accept_view<std::u16string_view>>("accept_u16string_view")
+
+        // arrays
+        .function<Marshalling::accept<std::vector<int8_t>>>("accept_byte_array")
+        .function<Marshalling::result<std::vector<int8_t>>>("result_byte_array")
+        .function<Marshalling::accept<std::vector<int32_t>>>("accept_int_array")
+        .function<Marshalling::result<std::vector<int32_t>>>("result_int_array")
+        .function<Marshalling::accept<std::vector<double>>>("accept_double_array")
+        .function<Marshalling::result<std::vector<double>>>("result_double_array")
+        .function<Marshalling::accept_view<std::basic_string_view<int8_t>>>("accept_byte_array_view")
+        .function<Marshalling::accept_view<std::basic_string_view<int32_t>>>("accept_int_array_view")
+        .function<Marshalling::accept_view<std::basic_string_view<double>>>("accept_double_array_view")
+        .function<Marshalling::accept<array_of<std::string>>>("accept_string_array")
+        .function<Marshalling::result<array_of<std::string>>>("result_string_array")
+        .function<Marshalling::accept<array_of<Point>>>("accept_point_array")
+        .function<Marshalling::result<array_of<Point>>>("result_point_array")
+
+        // records and enumerations
+        .function<Marshalling::accept<Point>>("accept_point")
+        .function<Marshalling::result<Point>>("result_point")
+        .function<Marshalling::accept<Color>>("accept_color")
+        .function<Marshalling::result<Color>>("result_color")
+
+        // date and time
+        .function<Marshalling::accept<std::chrono::nanoseconds>>("accept_duration")
+        .function<Marshalling::result<std::chrono::nanoseconds>>("result_duration")
+        .function<Marshalling::accept<std::chrono::system_clock::time_point>>("accept_instant")
+        .function<Marshalling::result<std::chrono::system_clock::time_point>>("result_instant")
+
+        // collections
+        .function<Marshalling::accept<std::vector<Point>>>("accept_list")
+        .function<Marshalling::result<std::vector<Point>>>("result_list")
+        .function<Marshalling::accept<std::set<std::string>>>("accept_ordered_set")
+        .function<Marshalling::result<std::set<std::string>>>("result_ordered_set")
+        .function<Marshalling::accept<std::unordered_set<std::string>>>("accept_unordered_set")
+        .function<Marshalling::result<std::unordered_set<std::string>>>("result_unordered_set")
+        .function<Marshalling::accept<std::map<std::string, int32_t>>>("accept_ordered_map")
+        .function<Marshalling::result<std::map<std::string, int32_t>>>("result_ordered_map")
+        .function<Marshalling::accept<std::unordered_map<std::string, int32_t>>>("accept_unordered_map")
+        .function<Marshalling::result<std::unordered_map<std::string, int32_t>>>("result_unordered_map")
+        .function<Marshalling::accept<std::optional<int32_t>>>("accept_optional_int")
+        .function<Marshalling::result<std::optional<int32_t>>>("result_optional_int")
+        .function<Marshalling::accept<std::optional<std::string>>>("accept_optional_string")
+        .function<Marshalling::result<std::optional<std::string>>>("result_optional_string")
+        .function<Marshalling::get_int_stream>("get_int_stream")
+
+        // functional interfaces
+        .function<Marshalling::invoke<bool, int32_t>>("invoke_int_predicate")
+        .function<Marshalling::invoke<void, int32_t>>("invoke_int_consumer")
+        .function<Marshalling::invoke<std::string, std::string>>("invoke_function")
+        .function<Marshalling::invoke<int32_t, std::string>>("invoke_to_int_function")
+        .function<Marshalling::get_int_predicate>("get_int_predicate")
+        .function<Marshalling::get_int_consumer>("get_int_consumer")
+        .function<Marshalling::get_function>("get_function")
+        .function<Marshalling::get_to_int_function>("get_to_int_function")
+        ;
+}
@@ -0,0 +1,425 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+/**
+ * Measures calls from C++ into Java (upcalls) in a Java VM embedded in this process.
+ *
+ * The harness starts a Java VM with `JNI_CreateJavaVM`, initializes javabind with `java_initialization_impl` as if
+ * the extension module had been loaded by Java, and invokes Java functional interfaces, `JavaOutput` and collection
+ * views from C++ threads, including the cost of attaching threads to the Java VM under concurrency.
+ *
+ * Usage: javabind_embedded_benchmark [--classpath path] [--threads count] [--time milliseconds] [--filter text]
+ *     [--output file.json] [--jvm-option option]...
+ */
+
+#include <javabind/javabind.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace javabind;
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    /** Number of operations between two reads of the clock, each batch running in its own local reference frame. */
+    constexpr std::size_t batch_size = 64;
+
+    struct Options
+    {
+        std::string classpath = "jar";
+        std::size_t threads = std::max(2u, std::thread::hardware_concurrency());
+        std::chrono::milliseconds time = std::chrono::milliseconds(1000);
+        std::string filter;
+        std::string output;
+        std::vector<std::string> jvm_options;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::size_t threads;
+        std::uint64_t iterations;
+        /** Average time of a single operation, as observed by the thread that performs it. */
+        double nanos_per_call;
+    };
+
+    /**
+     * Runs an operation repeatedly on a number of threads at the same time, after a warm-up period.
+     *
+     * Each thread calls `op` in batches, attaching to the Java VM (via `this_thread`) the first time the operation
+     * calls into Java, and detaching when the thread terminates.
+     */
+    template <typename Operation>
+    Result measure(const std::string& name, std::size_t threads, std::chrono::milliseconds time, Operation&& op)
+    {
+        std::atomic<std::size_t> ready = 0;
+        std::atomic<bool> start = false;
+        std::vector<std::uint64_t> counts(threads);
+        std::vector<double> elapsed(threads);
+
+        auto worker = [&](std::size_t index) {
+            auto run_until = [&op](clock_type::time_point deadline) {
+                std::uint64_t count = 0;
+                do {
+                    JNIEnv* env = this_thread.getEnv();
+                    LocalFrame frame(env, 4 * batch_size);
+                    for (std::size_t i = 0; i < batch_size; ++i) {
+                        op();
+                    }
+                    count += batch_size;
+                } while (clock_type::now() < deadline);
+                return count;
+            };
+
+            run_until(clock_type::now() + time);  // warm-up
+            ++ready;
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            clock_type::time_point begin = clock_type::now();
+            counts[index] = run_until(begin + time);
+            elapsed[index] = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin).count());
+        };
+
+        if (threads == 1) {
+            start = true;
+            worker(0);
+        } else {
+            std::vector<std::thread> pool;
+            for (std::size_t i = 0; i < threads; ++i) {
+                pool.emplace_back(worker, i);
+            }
+            while (ready.load() < threads) {
+                std::this_thread::yield();
+            }
+            start = true;
+            for (auto&& thread : pool) {
+                thread.join();
+            }
+        }
+
+        Result result{ name, threads, 0, 0.0 };
+        double total_nanos = 0.0;
+        for (std::size_t i = 0; i < threads; ++i) {
+            result.iterations += counts[i];
+            total_nanos += elapsed[i];
+        }
+        result.nanos_per_call = total_nanos / static_cast<double>(result.iterations);
+        return result;
+    }
+
+    /**
+     * Attaches the calling thread to the Java VM and detaches it, repeatedly, on a number of threads at the same time.
+     */
+    Result measure_attach(JavaVM* vm, std::size_t threads, std::chrono::milliseconds time)
+    {
+        std::atomic<bool> start = false;
+        std::vector<std::uint64_t> counts(threads);
+        std::vector<double> elapsed(threads);
+
+        auto worker = [&](std::size_t index) {
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            clock_type::time_point begin = clock_type::now();
+            clock_type::time_point deadline = begin + time;
+            std::uint64_t count = 0;
+            do {
+                JNIEnv* env;
+                if (vm->AttachCurrentThread(reinterpret_cast<void**>(&env), nullptr) != JNI_OK) {
+                    break;
+                }
+                vm->DetachCurrentThread();
+                ++count;
+            } while (clock_type::now() < deadline);
+            counts[index] = count;
+            elapsed[index] = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin).count());
+        };
+
+        std::vector<std::thread> pool;
+        for (std::size_t i = 0; i < threads; ++i) {
+            pool.emplace_back(worker, i);
+        }
+        start = true;
+        for (auto&& thread : pool) {
+            thread.join();
+        }
+
+        Result result{ "attach_detach", threads, 0, 0.0 };
+        double total_nanos = 0.0;
+        for (std::size_t i = 0; i < threads; ++i) {
+            result.iterations += counts[i];
+            total_nanos += elapsed[i];
+        }
+        result.nanos_per_call = result.iterations > 0 ? total_nanos / static_cast<double>(result.iterations) : 0.0;
+        return result;
+    }
+
+    /**
+     * Calls a static method of the Java helper class `Upcalls` that returns an object.
+     */
+    LocalObjectRef call_helper(JNIEnv* env, const char* name, const char* signature)
+    {
+        LocalClassRef cls(env, "hu/info/hunyadi/benchmark/Upcalls");
+        StaticMethod method = cls.getStaticMethod(name, signature);
+        jobject obj = env->CallStaticObjectMethod(cls.ref(), method.ref());
+        if (env->ExceptionCheck()) {
+            throw JavaException(env);
+        }
+        return LocalObjectRef(env, obj);
+    }
+
+    LocalObjectRef call_helper(JNIEnv* env, const char* name, const char* signature, jint size)
+    {
+        LocalClassRef cls(env, "hu/info/hunyadi/benchmark/Upcalls");
+        StaticMethod method = cls.getStaticMethod(name, signature);
+        jobject obj = env->CallStaticObjectMethod(cls.ref(), method.ref(), size);
+        if (env->ExceptionCheck()) {
+            throw JavaException(env);
+        }
+        return LocalObjectRef(env, obj);
+    }
+
+    template <typename T>
+    T native_value_of(JNIEnv* env, const LocalObjectRef& obj)
+    {
+        return arg_type_t<T>::native_value(env, static_cast<typename arg_type_t<T>::java_type>(obj.ref()));
+    }
+
+    void print(const Result& result)
+    {
+        std::cout << std::left << std::setw(40) << result.name << std::right << std::setw(8) << result.threads
+            << std::setw(14) << std::fixed << std::setprecision(1) << result.nanos_per_call << std::endl;
+    }
+
+    void write_json(const std::string& path, const std::vector<Result>& results)
+    {
+        std::ofstream os(path);
+        os << "{\n  \"benchmarks\": [\n";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            os << "    {\"name\": \"" << result.name << "\", \"threads\": " << result.threads
+                << ", \"iterations\": " << result.iterations
+                << ", \"ns_per_call\": " << std::fixed << std::setprecision(3) << result.nanos_per_call << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        os << "  ]\n}\n";
+        if (!os) {
+            throw std::runtime_error("cannot write benchmark results to " + path);
+        }
+    }
+
+    void run(JavaVM* vm, const Options& options)
+    {
+        JNIEnv* env = this_thread.getEnv();
+        std::vector<Result> results;
+
+        auto selected = [&options](const std::string& name) {
+            return name.find(options.filter) != std::string::npos;
+        };
+        auto add = [&results](Result result) {
+            print(result);
+            results.push_back(std::move(result));
+        };
+
+        std::cout << std::left << std::setw(40) << "benchmark" << std::right << std::setw(8) << "threads"
+            << std::setw(14) << "ns/call" << std::endl;
+
+        // function objects received from Java, invoked from the main thread and from several threads at once
+        auto function = native_value_of<std::function<std::string(std::string)>>(env, call_helper(env, "function", "()Ljava/util/function/Function;"));
+        auto int_predicate = native_value_of<std::function<bool(int32_t)>>(env, call_helper(env, "intPredicate", "()Ljava/util/function/IntPredicate;"));
+        auto int_consumer = native_value_of<std::function<void(int32_t)>>(env, call_helper(env, "intConsumer", "()Ljava/util/function/IntConsumer;"));
+        auto to_int_function = native_value_of<std::function<int32_t(std::string)>>(env, call_helper(env, "toIntFunction", "()Ljava/util/function/ToIntFunction;"));
+
+        std::vector<std::size_t> thread_counts = { 1 };
+        if (options.threads > 1) {
+            thread_counts.push_back(options.threads);
+        }
+        for (std::size_t threads : thread_counts) {
+            if (selected("function/upcall")) {
+                add(measure("function/upcall", threads, options.time, [&function]() { function("value"); }));
+            }
+            if (selected("int_predicate/upcall")) {
+                add(measure("int_predicate/upcall", threads, options.time, [&int_predicate]() { int_predicate(1); }));
+            }
+            if (selected("int_consumer/upcall")) {
+                add(measure("int_consumer/upcall", threads, options.time, [&int_consumer]() { int_consumer(1); }));
+            }
+            if (selected("to_int_function/upcall")) {
+                add(measure("to_int_function/upcall", threads, options.time, [&to_int_function]() { to_int_function("value"); }));
+            }
+        }
+
+        // printing to `System.out`, which the helper class replaces with a stream that discards output
+        if (selected("java_output/println")) {
+            call_helper(env, "discardOutput", "()Ljava/io/PrintStream;");
+            add(measure("java_output/println", 1, options.time, []() { JAVA_OUTPUT << "benchmark" << std::endl; }));
+        }
+
+        // collection views, which unpack elements lazily with JNI calls
+        for (jint size : { 16, 1024 }) {
+            std::string suffix = "[" + std::to_string(size) + "]";
+
+            GlobalObjectRef list(env, call_helper(env, "list", "(I)Ljava/util/List;", size).ref());
+            if (selected("list_view" + suffix + "/get")) {
+                add(measure("list_view" + suffix + "/get", 1, options.time, [&list]() {
+                    JNIEnv* env = this_thread.getEnv();
+                    list_view<std::string> view(env, list.ref());
+                    std::size_t count = view.size();
+                    for (std::size_t i = 0; i < count; ++i) {
+                        view.get(i);
+                    }
+                }));
+            }
+
+            GlobalObjectRef set(env, call_helper(env, "set", "(I)Ljava/util/Set;", size).ref());
+            if (selected("set_view" + suffix + "/iterate")) {
+                add(measure("set_view" + suffix + "/iterate", 1, options.time, [&set]() {
+                    JNIEnv* env = this_thread.getEnv();
+                    set_view<std::string> view(env, set.ref());
+                    auto it = view.iterator();
+                    while (it.has_next()) {
+                        it.get_next();
+                    }
+                }));
+            }
+
+            GlobalObjectRef map(env, call_helper(env, "map", "(I)Ljava/util/Map;", size).ref());
+            if (selected("map_view" + suffix + "/iterate")) {
+                add(measure("map_view" + suffix + "/iterate", 1, options.time, [&map]() {
+                    JNIEnv* env = this_thread.getEnv();
+                    map_view<std::string, boxed<int32_t>> view(env, map.ref());
+                    auto it = view.iterator();
+                    while (it.has_next()) {
+                        it.get_next();
+                    }
+                }));
+            }
+        }
+
+        // attaching and detaching threads, alone and under contention
+        if (selected("attach_detach")) {
+            for (std::size_t threads : thread_counts) {
+                add(measure_attach(vm, threads, options.time));
+            }
+        }
+
+        // a new thread that calls into Java once, which attaches on first use and detaches on termination
+        if (selected("thread/first_upcall")) {
+            add(measure("thread/first_upcall", 1, options.time, [&function]() {
+                std::thread([&function]() { function("value"); }).join();
+            }));
+        }
+
+        if (!options.output.empty()) {
+            write_json(options.output, results);
+        }
+    }
+
+    Options parse_options(int argc, char* argv[])
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for argument: " + arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--classpath") {
+                options.classpath = value;
+            } else if (arg == "--threads") {
+                options.threads = static_cast<std::size_t>(std::stoul(value));
+            } else if (arg == "--time") {
+                options.time = std::chrono::milliseconds(std::stol(value));
+            } else if (arg == "--filter") {
+                options.filter = value;
+            } else if (arg == "--output") {
+                options.output = value;
+            } else if (arg == "--jvm-option") {
+                options.jvm_options.push_back(value);
+            } else {
+                throw std::invalid_argument("unrecognized argument: " + arg);
+            }
+        }
+        return options;
+    }
+
+    /** Bindings are not needed, upcalls are made on objects obtained from the helper class `Upcalls`. */
+    void java_bindings_initializer()
+    {}
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> option_strings = { "-Djava.class.path=" + options.classpath };
+    option_strings.insert(option_strings.end(), options.jvm_options.begin(), options.jvm_options.end());
+    std::vector<JavaVMOption> vm_options;
+    for (auto&& option_string : option_strings) {
+        JavaVMOption vm_option = {};
+        vm_option.optionString = const_cast<char*>(option_string.c_str());
+        vm_options.push_back(vm_option);
+    }
+
+    JavaVMInitArgs vm_args = {};
+    vm_args.version = JNI_VERSION_1_6;
+    vm_args.nOptions = static_cast<jint>(vm_options.size());
+    vm_args.options = vm_options.data();
+    vm_args.ignoreUnrecognized = JNI_FALSE;
+
+    JavaVM* vm;
+    JNIEnv* env;
+    if (JNI_CreateJavaVM(&vm, reinterpret_cast<void**>(&env), &vm_args) != JNI_OK) {
+        std::cerr << "cannot create Java VM" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // initialize javabind as the Java VM would when loading an extension module
+    if (java_initialization_impl(vm, java_bindings_initializer) < 0 || env->ExceptionCheck()) {
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+        }
+        std::cerr << "cannot initialize javabind; is the test jar on the class path?" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int rc = EXIT_SUCCESS;
+    try {
+        run(vm, options);
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        rc = EXIT_FAILURE;
+    }
+
+    vm->DestroyJavaVM();
+
+    // static objects of javabind hold global references that must not be released once the Java VM is destroyed
+    std::cout.flush();
+    std::_Exit(rc);
+}
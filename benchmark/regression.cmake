@@ -0,0 +1,348 @@
+# Runs the marshalling benchmarks, and compares the results against a baseline with per-benchmark tolerances.
+#
+# Usage:
+#   cmake -D JAVA=<java> -D JAVAC=<javac> -D SOURCE_DIR=<repository> -D WORK_DIR=<scratch directory>
+#         -D LIBRARY_DIR=<directory of javabind_benchmark> -D BASELINE=<baseline.json>
+#         -D LOCAL_BASELINE=<local_baseline.json> [-D BUILD_TYPE=<Release>] [-D TIME_MS=<200>] [-D UPDATE_BASELINE=ON]
+#         -P regression.cmake
+#
+# Timings, Java heap bytes and native allocations per call are measured with the library `javabind_benchmark`.
+# JNI calls per call are counted with the library `javabind_benchmark_accounting`, built with JAVABIND_JNI_ACCOUNTING.
+# Every run is compared against LOCAL_BASELINE, a file that is not committed, keyed by build type, and recorded on the
+# first run with that build type. JNI calls and native allocations do not depend on the machine, and are compared
+# against BASELINE instead if it is committed with counts for the benchmark, recorded with a Java VM.
+# With UPDATE_BASELINE, counts are written to BASELINE, keeping its tolerances, and all results to LOCAL_BASELINE.
+
+cmake_minimum_required(VERSION 3.24)
+
+foreach(var JAVA JAVAC SOURCE_DIR WORK_DIR LIBRARY_DIR BASELINE LOCAL_BASELINE)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} must be defined")
+    endif()
+endforeach()
+if(NOT DEFINED TIME_MS)
+    set(TIME_MS 200)
+endif()
+if(NOT DEFINED BUILD_TYPE OR BUILD_TYPE STREQUAL "")
+    set(BUILD_TYPE "default")
+endif()
+
+# converts a decimal number such as 12.345 into an integer number of thousandths, since `math` has no floating point
+function(to_milli value out_var)
+    if(NOT value MATCHES "^(-?)([0-9]+)(\\.([0-9]*))?$")
+        message(FATAL_ERROR "Not a decimal number: ${value}")
+    endif()
+    set(sign "${CMAKE_MATCH_1}")
+    set(integral "${CMAKE_MATCH_2}")
+    set(fraction "${CMAKE_MATCH_4}0000")
+    string(SUBSTRING "${fraction}" 0 4 fraction)
+    string(REGEX REPLACE "^0+([0-9])" "\\1" integral "${integral}")
+    string(REGEX REPLACE "^0+([0-9])" "\\1" fraction "${fraction}")
+    math(EXPR milli "${integral} * 1000 + (${fraction} + 5) / 10")
+    if(sign)
+        math(EXPR milli "-${milli}")
+    endif()
+    set(${out_var} ${milli} PARENT_SCOPE)
+endfunction()
+
+# converts an integer number of thousandths back into a decimal number for display
+function(from_milli milli out_var)
+    set(sign "")
+    if(milli LESS 0)
+        set(sign "-")
+        math(EXPR milli "-${milli}")
+    endif()
+    math(EXPR integral "${milli} / 1000")
+    math(EXPR fraction "${milli} % 1000 + 1000")
+    string(SUBSTRING "${fraction}" 1 3 fraction)
+    set(${out_var} "${sign}${integral}.${fraction}" PARENT_SCOPE)
+endfunction()
+
+# rounds a decimal number to three fractional digits, the precision in which results are stored
+function(to_decimal value out_var)
+    to_milli(${value} milli)
+    from_milli(${milli} decimal)
+    set(${out_var} ${decimal} PARENT_SCOPE)
+endfunction()
+
+# returns a JSON value as text, or an empty string if the value is missing or null
+function(json_value out_var json)
+    string(JSON type ERROR_VARIABLE error TYPE "${json}" ${ARGN})
+    if(error OR type STREQUAL "NULL")
+        set(${out_var} "" PARENT_SCOPE)
+    else()
+        string(JSON value GET "${json}" ${ARGN})
+        set(${out_var} "${value}" PARENT_SCOPE)
+    endif()
+endfunction()
+
+function(run_benchmark output)
+    execute_process(
+        COMMAND "${JAVA}" "-Djava.library.path=${LIBRARY_DIR}" -cp "${WORK_DIR}/classes"
+            hu.info.hunyadi.benchmark.Benchmark ${ARGN} --output "${output}"
+        RESULT_VARIABLE rc
+    )
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "Benchmark failed: ${rc}")
+    endif()
+endfunction()
+
+# compile and run the Java benchmark application
+file(GLOB_RECURSE java_sources "${SOURCE_DIR}/java/*.java")
+file(REMOVE_RECURSE "${WORK_DIR}/classes")
+file(MAKE_DIRECTORY "${WORK_DIR}/classes")
+execute_process(
+    COMMAND "${JAVAC}" -d "${WORK_DIR}/classes" -cp "${SOURCE_DIR}/java" ${java_sources}
+    RESULT_VARIABLE rc
+)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "Cannot compile Java sources: ${rc}")
+endif()
+
+run_benchmark("${WORK_DIR}/timing.json" --time ${TIME_MS})
+run_benchmark("${WORK_DIR}/jni_calls.json" --library javabind_benchmark_accounting --jni-calls)
+
+# merge the two runs into a single object keyed by benchmark name
+file(READ "${WORK_DIR}/timing.json" timing)
+file(READ "${WORK_DIR}/jni_calls.json" jni_calls)
+set(current "{}")
+set(names "")
+string(JSON count LENGTH "${timing}" benchmarks)
+math(EXPR last "${count} - 1")
+foreach(index RANGE ${last})
+    string(JSON entry GET "${timing}" benchmarks ${index})
+    string(JSON name GET "${entry}" name)
+    list(APPEND names "${name}")
+    set(record "{}")
+    foreach(key ns_per_call java_bytes_per_call native_allocations_per_call)
+        json_value(value "${entry}" ${key})
+        if(value STREQUAL "")
+            set(value "null")
+        endif()
+        string(JSON record SET "${record}" ${key} "${value}")
+    endforeach()
+    string(JSON record SET "${record}" jni_calls_per_call "{}")
+    string(JSON current SET "${current}" "${name}" "${record}")
+endforeach()
+string(JSON count LENGTH "${jni_calls}" benchmarks)
+math(EXPR last "${count} - 1")
+foreach(index RANGE ${last})
+    string(JSON entry GET "${jni_calls}" benchmarks ${index})
+    string(JSON name GET "${entry}" name)
+    string(JSON calls GET "${entry}" jni_calls_per_call)
+    string(JSON current SET "${current}" "${name}" jni_calls_per_call "${calls}")
+endforeach()
+
+file(READ "${BASELINE}" baseline)
+set(local_baseline "{}")
+if(EXISTS "${LOCAL_BASELINE}")
+    file(READ "${LOCAL_BASELINE}" local_baseline)
+endif()
+
+# formats the deterministic counts of a benchmark as a single line of JSON
+function(format_counts record out_var)
+    json_value(allocations "${record}" native_allocations_per_call)
+    if(allocations STREQUAL "")
+        set(allocations "null")
+    else()
+        to_decimal(${allocations} allocations)
+    endif()
+    string(JSON calls GET "${record}" jni_calls_per_call)
+    string(JSON count LENGTH "${calls}")
+    set(items "")
+    if(count GREATER 0)
+        math(EXPR last "${count} - 1")
+        foreach(index RANGE ${last})
+            string(JSON function MEMBER "${calls}" ${index})
+            string(JSON value GET "${calls}" ${function})
+            to_decimal(${value} value)
+            if(NOT items STREQUAL "")
+                string(APPEND items ", ")
+            endif()
+            string(APPEND items "\"${function}\": ${value}")
+        endforeach()
+    endif()
+    set(${out_var} "{\"native_allocations_per_call\": ${allocations}, \"jni_calls_per_call\": {${items}}}" PARENT_SCOPE)
+endfunction()
+
+# stores the results of the current run as the local baseline of the build type
+function(write_local_baseline)
+    string(JSON updated SET "${local_baseline}" "${BUILD_TYPE}" "${current}")
+    file(WRITE "${LOCAL_BASELINE}" "${updated}\n")
+endfunction()
+
+if(UPDATE_BASELINE)
+    # one line per benchmark in the order of the suite, such that a change of the baseline is easy to review
+    set(lines "")
+    foreach(name IN LISTS names)
+        string(JSON record GET "${current}" "${name}")
+        format_counts("${record}" counts)
+        if(NOT lines STREQUAL "")
+            string(APPEND lines ",\n")
+        endif()
+        string(APPEND lines "    \"${name}\": ${counts}")
+    endforeach()
+    string(FIND "${baseline}" "\"benchmarks\"" position)
+    if(position LESS 0)
+        message(FATAL_ERROR "Property benchmarks not found in ${BASELINE}")
+    endif()
+    string(SUBSTRING "${baseline}" 0 ${position} head)
+    file(WRITE "${BASELINE}" "${head}\"benchmarks\": {\n${lines}\n  }\n}\n")
+    list(LENGTH names count)
+    message(STATUS "Baseline of ${count} benchmarks written to ${BASELINE}")
+
+    write_local_baseline()
+    message(STATUS "Results of build type '${BUILD_TYPE}' written to ${LOCAL_BASELINE}")
+    return()
+endif()
+
+# look up tolerances, the first override whose pattern matches the benchmark name takes precedence
+function(tolerance name key out_var)
+    string(JSON count LENGTH "${baseline}" tolerances overrides)
+    if(count GREATER 0)
+        math(EXPR last "${count} - 1")
+        foreach(index RANGE ${last})
+            string(JSON pattern GET "${baseline}" tolerances overrides ${index} match)
+            if(name MATCHES "${pattern}")
+                json_value(value "${baseline}" tolerances overrides ${index} ${key})
+                if(NOT value STREQUAL "")
+                    set(${out_var} "${value}" PARENT_SCOPE)
+                    return()
+                endif()
+            endif()
+        endforeach()
+    endif()
+    string(JSON value GET "${baseline}" tolerances default ${key})
+    set(${out_var} "${value}" PARENT_SCOPE)
+endfunction()
+
+# timings are only meaningful on the same machine with the same build type, record them on first use
+string(JSON recorded ERROR_VARIABLE missing GET "${local_baseline}" "${BUILD_TYPE}")
+if(missing)
+    set(recorded "{}")
+    write_local_baseline()
+    message(STATUS "No results of build type '${BUILD_TYPE}' in ${LOCAL_BASELINE}, recorded the current run for comparison in later runs")
+endif()
+
+set(failures "")
+set(notices "")
+foreach(name IN LISTS names)
+    string(JSON cur GET "${current}" "${name}")
+
+    # time per call, relative tolerance
+    json_value(base_value "${recorded}" "${name}" ns_per_call)
+    json_value(cur_value "${cur}" ns_per_call)
+    if(NOT base_value STREQUAL "" AND NOT cur_value STREQUAL "")
+        tolerance("${name}" ns_per_call_percent percent)
+        to_milli(${base_value} base_milli)
+        to_milli(${cur_value} cur_milli)
+        math(EXPR limit "${base_milli} * (100 + ${percent}) / 100")
+        if(cur_milli GREATER limit)
+            math(EXPR change "(${cur_milli} - ${base_milli}) * 100 / (${base_milli} + 1)")
+            list(APPEND failures "REGRESSION  ${name}: ns_per_call ${base_value} -> ${cur_value} (+${change}%, tolerance ${percent}%)")
+        endif()
+    endif()
+
+    # bytes allocated on the Java heap per call, relative tolerance with an absolute allowance
+    json_value(base_value "${recorded}" "${name}" java_bytes_per_call)
+    json_value(cur_value "${cur}" java_bytes_per_call)
+    if(NOT base_value STREQUAL "" AND NOT cur_value STREQUAL "")
+        tolerance("${name}" java_bytes_per_call_percent percent)
+        tolerance("${name}" java_bytes_per_call_absolute absolute)
+        to_milli(${base_value} base_milli)
+        to_milli(${cur_value} cur_milli)
+        to_milli(${absolute} absolute_milli)
+        math(EXPR limit "${base_milli} * (100 + ${percent}) / 100 + ${absolute_milli}")
+        if(cur_milli GREATER limit)
+            list(APPEND failures "REGRESSION  ${name}: java_bytes_per_call ${base_value} -> ${cur_value} (tolerance ${percent}% + ${absolute})")
+        endif()
+    endif()
+
+    # counts recorded with a Java VM and committed take precedence over counts recorded locally
+    string(JSON base ERROR_VARIABLE missing GET "${baseline}" benchmarks "${name}")
+    if(missing)
+        string(JSON base ERROR_VARIABLE missing GET "${recorded}" "${name}")
+        if(missing)
+            list(APPEND notices "NEW         ${name}: not in baseline")
+            continue()
+        endif()
+    endif()
+
+    # native heap allocations per call, absolute tolerance
+    json_value(base_value "${base}" native_allocations_per_call)
+    json_value(cur_value "${cur}" native_allocations_per_call)
+    if(NOT base_value STREQUAL "" AND NOT cur_value STREQUAL "")
+        tolerance("${name}" native_allocations_per_call_absolute absolute)
+        to_milli(${base_value} base_milli)
+        to_milli(${cur_value} cur_milli)
+        to_milli(${absolute} absolute_milli)
+        math(EXPR limit "${base_milli} + ${absolute_milli}")
+        if(cur_milli GREATER limit)
+            list(APPEND failures "REGRESSION  ${name}: native_allocations_per_call ${base_value} -> ${cur_value} (tolerance ${absolute})")
+        endif()
+    endif()
+    # JNI calls per call, exact match of each JNI function
+    json_value(base_calls "${base}" jni_calls_per_call)
+    json_value(cur_calls "${cur}" jni_calls_per_call)
+    if(NOT base_calls STREQUAL "" AND NOT cur_calls STREQUAL "")
+        set(functions "")
+        foreach(calls IN ITEMS "${base_calls}" "${cur_calls}")
+            string(JSON count LENGTH "${calls}")
+            if(count GREATER 0)
+                math(EXPR last "${count} - 1")
+                foreach(index RANGE ${last})
+                    string(JSON function MEMBER "${calls}" ${index})
+                    list(APPEND functions "${function}")
+                endforeach()
+            endif()
+        endforeach()
+        list(REMOVE_DUPLICATES functions)
+        list(SORT functions)
+        foreach(function IN LISTS functions)
+            json_value(base_count "${base_calls}" ${function})
+            json_value(cur_count "${cur_calls}" ${function})
+            set(base_milli 0)
+            set(cur_milli 0)
+            if(NOT base_count STREQUAL "")
+                to_milli(${base_count} base_milli)
+            endif()
+            if(NOT cur_count STREQUAL "")
+                to_milli(${cur_count} cur_milli)
+            endif()
+            if(NOT base_milli EQUAL cur_milli)
+                from_milli(${base_milli} base_text)
+                from_milli(${cur_milli} cur_text)
+                if(cur_milli GREATER base_milli)
+                    list(APPEND failures "REGRESSION  ${name}: JNI ${function} ${base_text} -> ${cur_text} per call")
+                else()
+                    list(APPEND failures "CHANGED     ${name}: JNI ${function} ${base_text} -> ${cur_text} per call (update the baseline)")
+                endif()
+            endif()
+        endforeach()
+    endif()
+endforeach()
+
+# benchmarks in the baseline that have not been run
+string(JSON count LENGTH "${baseline}" benchmarks)
+if(count GREATER 0)
+    math(EXPR last "${count} - 1")
+    foreach(index RANGE ${last})
+        string(JSON name MEMBER "${baseline}" benchmarks ${index})
+        if(NOT name IN_LIST names)
+            list(APPEND failures "MISSING     ${name}: in baseline but not run")
+        endif()
+    endforeach()
+endif()
+
+foreach(line IN LISTS notices)
+    message(STATUS "${line}")
+endforeach()
+list(LENGTH failures failure_count)
+if(failure_count GREATER 0)
+    foreach(line IN LISTS failures)
+        message(NOTICE "${line}")
+    endforeach()
+    message(FATAL_ERROR "${failure_count} benchmark regression(s) against ${BASELINE} and ${LOCAL_BASELINE}")
+endif()
+list(LENGTH names count)
+message(STATUS "${count} benchmarks within tolerance of ${BASELINE} and ${LOCAL_BASELINE}")
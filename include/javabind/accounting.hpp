@@ -0,0 +1,506 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include <jni.h>
+#include "tracking.hpp"
+
+#include <string_view>
+
+#if defined(JAVABIND_JNI_ACCOUNTING) || defined(JAVABIND_LOCAL_REF_TRACKING)
+#define JAVABIND_JNI_INTERCEPTION
+#include <cstdarg>
+#include <cstddef>
+#include <type_traits>
+#endif
+
+#if defined(JAVABIND_JNI_ACCOUNTING)
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#endif
+
+namespace javabind
+{
+#if defined(JAVABIND_JNI_INTERCEPTION)
+
+#define JAVABIND_JNI_PRIMITIVE(F, prefix, suffix) \
+    F(prefix##Boolean##suffix) F(prefix##Byte##suffix) F(prefix##Char##suffix) F(prefix##Short##suffix) \
+    F(prefix##Int##suffix) F(prefix##Long##suffix) F(prefix##Float##suffix) F(prefix##Double##suffix)
+
+#define JAVABIND_JNI_TYPED(F, prefix, suffix) \
+    F(prefix##Object##suffix) JAVABIND_JNI_PRIMITIVE(F, prefix, suffix)
+
+#define JAVABIND_JNI_CALL_METHOD(F, V, prefix, type) \
+    V(prefix##type##Method) F(prefix##type##MethodV) F(prefix##type##MethodA)
+
+#define JAVABIND_JNI_CALL(F, V, prefix) \
+    JAVABIND_JNI_CALL_METHOD(F, V, prefix, Object) JAVABIND_JNI_CALL_METHOD(F, V, prefix, Boolean) \
+    JAVABIND_JNI_CALL_METHOD(F, V, prefix, Byte) JAVABIND_JNI_CALL_METHOD(F, V, prefix, Char) \
+    JAVABIND_JNI_CALL_METHOD(F, V, prefix, Short) JAVABIND_JNI_CALL_METHOD(F, V, prefix, Int) \
+    JAVABIND_JNI_CALL_METHOD(F, V, prefix, Long) JAVABIND_JNI_CALL_METHOD(F, V, prefix, Float) \
+    JAVABIND_JNI_CALL_METHOD(F, V, prefix, Double) JAVABIND_JNI_CALL_METHOD(F, V, prefix, Void)
+
+#if defined(JNI_VERSION_9)
+#define JAVABIND_JNI_FUNCTIONS_9(F) F(GetModule)
+#else
+#define JAVABIND_JNI_FUNCTIONS_9(F)
+#endif
+#if defined(JNI_VERSION_19)
+#define JAVABIND_JNI_FUNCTIONS_19(F) F(IsVirtualThread)
+#else
+#define JAVABIND_JNI_FUNCTIONS_19(F)
+#endif
+#if defined(JNI_VERSION_24)
+#define JAVABIND_JNI_FUNCTIONS_24(F) F(GetStringUTFLengthAsLong)
+#else
+#define JAVABIND_JNI_FUNCTIONS_24(F)
+#endif
+
+    /**
+     * Lists all entries of the JNI function table. `F` is applied to regular functions, and `V` is applied to
+     * functions with a C variable argument list, which are forwarded to their `va_list` counterpart.
+     */
+#define JAVABIND_JNI_FUNCTIONS(F, V) \
+    F(GetVersion) F(DefineClass) F(FindClass) F(FromReflectedMethod) F(FromReflectedField) F(ToReflectedMethod) \
+    F(GetSuperclass) F(IsAssignableFrom) F(ToReflectedField) F(Throw) F(ThrowNew) F(ExceptionOccurred) \
+    F(ExceptionDescribe) F(ExceptionClear) F(FatalError) F(PushLocalFrame) F(PopLocalFrame) F(NewGlobalRef) \
+    F(DeleteGlobalRef) F(DeleteLocalRef) F(IsSameObject) F(NewLocalRef) F(EnsureLocalCapacity) F(AllocObject) \
+    V(NewObject) F(NewObjectV) F(NewObjectA) F(GetObjectClass) F(IsInstanceOf) F(GetMethodID) \
+    JAVABIND_JNI_CALL(F, V, Call) JAVABIND_JNI_CALL(F, V, CallNonvirtual) \
+    F(GetFieldID) JAVABIND_JNI_TYPED(F, Get, Field) JAVABIND_JNI_TYPED(F, Set, Field) \
+    F(GetStaticMethodID) JAVABIND_JNI_CALL(F, V, CallStatic) \
+    F(GetStaticFieldID) JAVABIND_JNI_TYPED(F, GetStatic, Field) JAVABIND_JNI_TYPED(F, SetStatic, Field) \
+    F(NewString) F(GetStringLength) F(GetStringChars) F(ReleaseStringChars) \
+    F(NewStringUTF) F(GetStringUTFLength) F(GetStringUTFChars) F(ReleaseStringUTFChars) \
+    F(GetArrayLength) F(NewObjectArray) F(GetObjectArrayElement) F(SetObjectArrayElement) \
+    JAVABIND_JNI_PRIMITIVE(F, New, Array) JAVABIND_JNI_PRIMITIVE(F, Get, ArrayElements) \
+    JAVABIND_JNI_PRIMITIVE(F, Release, ArrayElements) JAVABIND_JNI_PRIMITIVE(F, Get, ArrayRegion) \
+    JAVABIND_JNI_PRIMITIVE(F, Set, ArrayRegion) \
+    F(RegisterNatives) F(UnregisterNatives) F(MonitorEnter) F(MonitorExit) F(GetJavaVM) \
+    F(GetStringRegion) F(GetStringUTFRegion) F(GetPrimitiveArrayCritical) F(ReleasePrimitiveArrayCritical) \
+    F(GetStringCritical) F(ReleaseStringCritical) F(NewWeakGlobalRef) F(DeleteWeakGlobalRef) F(ExceptionCheck) \
+    F(NewDirectByteBuffer) F(GetDirectBufferAddress) F(GetDirectBufferCapacity) F(GetObjectRefType) \
+    JAVABIND_JNI_FUNCTIONS_9(F) JAVABIND_JNI_FUNCTIONS_19(F) JAVABIND_JNI_FUNCTIONS_24(F)
+
+#define JAVABIND_JNI_ENUM(name) name,
+#define JAVABIND_JNI_NAME(name) #name,
+
+    /**
+     * Identifies a JNI function, or a derived counter that follows the last JNI function.
+     */
+    enum class jni_function : std::size_t
+    {
+        JAVABIND_JNI_FUNCTIONS(JAVABIND_JNI_ENUM, JAVABIND_JNI_ENUM)
+        /** Number of calls that returned a new local reference. */
+        LocalRefs
+    };
+
+    constexpr std::size_t jni_function_count = static_cast<std::size_t>(jni_function::LocalRefs);
+    constexpr std::size_t jni_counter_count = jni_function_count + 1;
+
+    constexpr const char* jni_function_names[jni_counter_count] = {
+        JAVABIND_JNI_FUNCTIONS(JAVABIND_JNI_NAME, JAVABIND_JNI_NAME)
+        "LocalRefs"
+    };
+
+#undef JAVABIND_JNI_ENUM
+#undef JAVABIND_JNI_NAME
+
+    static_assert(
+        sizeof(JNINativeInterface_) == (4 + jni_function_count) * sizeof(void*),
+        "The list of JNI functions does not match the JNI function table of the JDK."
+    );
+#endif
+
+#if defined(JAVABIND_JNI_ACCOUNTING)
+    /**
+     * Counts calls to JNI functions made by javabind, attributed to the native function binding and the type
+     * converter (`ArgType`) that made them.
+     *
+     * Accounting relies on the `JNIEnv` that javabind uses being a thin wrapper whose function table counts each call
+     * before forwarding it to the original environment (see `JNIInterception`). Native code that calls JNI with the
+     * environment obtained from javabind is accounted for, too.
+     */
+    class JNIAccounting
+    {
+    public:
+        /** Call counts of JNI functions, indexed by `jni_function`. */
+        using tally_type = std::array<std::atomic<std::uint64_t>, jni_counter_count>;
+
+        /**
+         * Attributes JNI calls made by the current thread to a native function binding while in scope.
+         *
+         * @param binding The entry point of the native function binding.
+         */
+        class binding_scope
+        {
+        public:
+            explicit binding_scope(const void* binding)
+                : _outer_binding(_binding)
+                , _outer_tally(_tally)
+            {
+                _binding = binding;
+                _tally = &tally_of(binding, std::string_view());
+            }
+
+            binding_scope(const binding_scope&) = delete;
+            binding_scope& operator=(const binding_scope&) = delete;
+
+            ~binding_scope()
+            {
+                _binding = _outer_binding;
+                _tally = _outer_tally;
+            }
+
+        private:
+            const void* _outer_binding;
+            tally_type* _outer_tally;
+        };
+
+        /**
+         * Attributes JNI calls made by the current thread to a type converter of the active binding while in scope.
+         *
+         * @param java_name The Java type that the converter maps, e.g. `java.time.Instant`.
+         */
+        class type_scope
+        {
+        public:
+            explicit type_scope(std::string_view java_name)
+                : _outer_tally(_tally)
+            {
+                _tally = &tally_of(_binding, java_name);
+            }
+
+            type_scope(const type_scope&) = delete;
+            type_scope& operator=(const type_scope&) = delete;
+
+            ~type_scope()
+            {
+                _tally = _outer_tally;
+            }
+
+        private:
+            tally_type* _outer_tally;
+        };
+
+        /**
+         * Associates a human-readable name with the entry point of a native function binding.
+         */
+        static void name(const void* binding, std::string name)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _names[binding] = std::move(name);
+        }
+
+        /**
+         * Number of calls to a JNI function made on behalf of a native function binding, summed over type converters.
+         *
+         * @param binding Name of the binding as registered with `name`, e.g. `hu.info.hunyadi.test.StaticSample.pass_int`.
+         * @param function Name of the JNI function, e.g. `FindClass`.
+         */
+        static std::uint64_t count(std::string_view binding, std::string_view function)
+        {
+            std::size_t index = 0;
+            while (index < jni_counter_count && function != jni_function_names[index]) {
+                ++index;
+            }
+            if (index == jni_counter_count) {
+                return 0;
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::uint64_t total = 0;
+            for (auto&& [key, tally] : _tallies) {
+                if (name_of(key.first) == binding) {
+                    total += (*tally)[index].load(std::memory_order_relaxed);
+                }
+            }
+            return total;
+        }
+
+        /**
+         * Writes the number of calls to each JNI function, one line per binding and type converter that made calls.
+         */
+        static void report(std::ostream& os)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto&& [key, tally] : _tallies) {
+                bool empty = true;
+                for (std::size_t i = 0; i < jni_counter_count; ++i) {
+                    std::uint64_t value = (*tally)[i].load(std::memory_order_relaxed);
+                    if (value == 0) {
+                        continue;
+                    }
+                    if (empty) {
+                        os << name_of(key.first);
+                        if (!key.second.empty()) {
+                            os << " [" << key.second << "]";
+                        }
+                        os << ":";
+                        empty = false;
+                    }
+                    os << " " << jni_function_names[i] << "=" << value;
+                }
+                if (!empty) {
+                    os << "\n";
+                }
+            }
+        }
+
+        static void reset()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto&& [key, tally] : _tallies) {
+                for (auto&& value : *tally) {
+                    value.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
+    private:
+        friend class JNIInterception;
+
+        static void record(jni_function index)
+        {
+            tally_type* tally = _tally;
+            if (tally == nullptr) {
+                tally = &tally_of(nullptr, std::string_view());
+                _tally = tally;
+            }
+            (*tally)[static_cast<std::size_t>(index)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static tally_type& tally_of(const void* binding, std::string_view java_name)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto&& tally = _tallies[std::make_pair(binding, java_name)];
+            if (!tally) {
+                tally = std::make_unique<tally_type>();
+            }
+            return *tally;
+        }
+
+        /** Must be called with the mutex held. */
+        static std::string_view name_of(const void* binding)
+        {
+            if (binding == nullptr) {
+                return "(unattributed)";
+            }
+            auto it = _names.find(binding);
+            if (it == _names.end()) {
+                return "(unknown)";
+            }
+            return it->second;
+        }
+
+        inline static std::mutex _mutex;
+        inline static std::map<std::pair<const void*, std::string_view>, std::unique_ptr<tally_type>> _tallies;
+        inline static std::map<const void*, std::string> _names;
+        inline static thread_local const void* _binding = nullptr;
+        inline static thread_local tally_type* _tally = nullptr;
+    };
+#else
+    /**
+     * Placeholder for JNI call accounting when instrumentation is disabled, optimized away entirely.
+     */
+    struct JNIAccounting
+    {
+        struct binding_scope
+        {
+            explicit binding_scope(const void*)
+            {}
+        };
+
+        struct type_scope
+        {
+            explicit type_scope(std::string_view)
+            {}
+        };
+    };
+#endif
+
+#if defined(JAVABIND_JNI_INTERCEPTION)
+    /**
+     * Intercepts calls to JNI functions for accounting (`JNIAccounting`) and local reference tracking
+     * (`LocalRefTracker`).
+     *
+     * Interception replaces the `JNIEnv` that javabind uses with a thin wrapper whose function table observes each
+     * call before and after forwarding it to the original environment.
+     */
+    class JNIInterception
+    {
+    public:
+        /**
+         * Returns an environment whose JNI calls are intercepted, or the environment itself if it is already intercepted.
+         */
+        static JNIEnv* wrap(JNIEnv* env)
+        {
+            if (env == nullptr || env->functions == table(env)) {
+                return env;
+            }
+            thread_local InterceptingEnv wrapper;
+            wrapper.functions = table(env);
+            wrapper.real = env;
+            return &wrapper;
+        }
+
+    private:
+        struct InterceptingEnv : JNIEnv
+        {
+            JNIEnv* real;
+        };
+
+        template <jni_function Index, auto Member, typename Fn>
+        struct Trampoline;
+
+        template <jni_function Index, auto Member, typename R, typename... Args>
+        struct Trampoline<Index, Member, R (JNICALL*)(JNIEnv*, Args...)>
+        {
+            static R JNICALL invoke(JNIEnv* env, Args... args)
+            {
+                JNIEnv* real = static_cast<InterceptingEnv*>(env)->real;
+                called<Index>(args...);
+                if constexpr (std::is_void_v<R>) {
+                    (real->functions->*Member)(real, args...);
+                } else {
+                    return returned<Index>((real->functions->*Member)(real, args...));
+                }
+            }
+        };
+
+        /** Forwards a function with a C variable argument list to its counterpart that takes a `va_list`. */
+        template <jni_function Index, auto Member, typename Fn>
+        struct VariadicTrampoline;
+
+        template <jni_function Index, auto Member, typename R, typename Target>
+        struct VariadicTrampoline<Index, Member, R (JNICALL*)(JNIEnv*, Target, jmethodID, ...)>
+        {
+            static R JNICALL invoke(JNIEnv* env, Target target, jmethodID method, ...)
+            {
+                JNIEnv* real = static_cast<InterceptingEnv*>(env)->real;
+                called<Index>();
+                va_list args;
+                va_start(args, method);
+                if constexpr (std::is_void_v<R>) {
+                    (real->functions->*Member)(real, target, method, args);
+                    va_end(args);
+                } else {
+                    R result = (real->functions->*Member)(real, target, method, args);
+                    va_end(args);
+                    return returned<Index>(result);
+                }
+            }
+        };
+
+        template <jni_function Index, auto Member, typename R, typename Target, typename Class>
+        struct VariadicTrampoline<Index, Member, R (JNICALL*)(JNIEnv*, Target, Class, jmethodID, ...)>
+        {
+            static R JNICALL invoke(JNIEnv* env, Target target, Class cls, jmethodID method, ...)
+            {
+                JNIEnv* real = static_cast<InterceptingEnv*>(env)->real;
+                called<Index>();
+                va_list args;
+                va_start(args, method);
+                if constexpr (std::is_void_v<R>) {
+                    (real->functions->*Member)(real, target, cls, method, args);
+                    va_end(args);
+                } else {
+                    R result = (real->functions->*Member)(real, target, cls, method, args);
+                    va_end(args);
+                    return returned<Index>(result);
+                }
+            }
+        };
+
+        static const JNINativeInterface_* table(JNIEnv* env)
+        {
+            static const JNINativeInterface_ instance = make_table(*env->functions);
+            return &instance;
+        }
+
+        static JNINativeInterface_ make_table(const JNINativeInterface_& original)
+        {
+            JNINativeInterface_ t = original;
+
+#define JAVABIND_JNI_TRAMPOLINE(name) \
+            t.name = &Trampoline<jni_function::name, &JNINativeInterface_::name, decltype(t.name)>::invoke;
+#define JAVABIND_JNI_VARIADIC_TRAMPOLINE(name) \
+            t.name = &VariadicTrampoline<jni_function::name, &JNINativeInterface_::name##V, decltype(t.name)>::invoke;
+
+            JAVABIND_JNI_FUNCTIONS(JAVABIND_JNI_TRAMPOLINE, JAVABIND_JNI_VARIADIC_TRAMPOLINE)
+
+#undef JAVABIND_JNI_TRAMPOLINE
+#undef JAVABIND_JNI_VARIADIC_TRAMPOLINE
+
+            return t;
+        }
+
+        /** Observes a call to a JNI function before it is forwarded to the original environment. */
+        template <jni_function Index, typename... Args>
+        static void called([[maybe_unused]] Args... args)
+        {
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            JNIAccounting::record(Index);
+#endif
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+            if constexpr (Index == jni_function::DeleteLocalRef) {
+                LocalRefTracker::release(args...);
+            } else if constexpr (Index == jni_function::PopLocalFrame) {
+                LocalRefTracker::pop_frame();
+            }
+#endif
+        }
+
+        /** Observes the result of a JNI function, such as a new local reference. */
+        template <jni_function Index, typename R>
+        static R returned(R result)
+        {
+            if constexpr (std::is_convertible_v<R, jobject>) {
+                if (result != nullptr && Index != jni_function::NewGlobalRef && Index != jni_function::NewWeakGlobalRef) {
+#if defined(JAVABIND_JNI_ACCOUNTING)
+                    JNIAccounting::record(jni_function::LocalRefs);
+#endif
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+                    LocalRefTracker::acquire(result);
+#endif
+                }
+            }
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+            if constexpr (Index == jni_function::PushLocalFrame) {
+                if (result == JNI_OK) {
+                    LocalRefTracker::push_frame();
+                }
+            }
+#endif
+            return result;
+        }
+    };
+
+    /**
+     * Returns an environment whose JNI calls are counted and whose local references are tracked.
+     */
+    inline JNIEnv* accounted(JNIEnv* env)
+    {
+        return JNIInterception::wrap(env);
+    }
+#else
+    inline JNIEnv* accounted(JNIEnv* env)
+    {
+        return env;
+    }
+#endif
+}
@@ -0,0 +1,396 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "executor.hpp"
+#include "global.hpp"
+#include "object.hpp"
+#include "message.hpp"
+#include "signature.hpp"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace javabind
+{
+    /**
+     * A native vector that maps to a Java object array (e.g. `String[]` or `Rectangle[]`) instead of a Java List.
+     *
+     * Object arrays are cheaper to build than lists, as elements are stored without a method call per element.
+     */
+    template <typename T>
+    struct array_of : std::vector<T>
+    {
+        static_assert(!std::is_arithmetic_v<T>, "Use std::vector<T> to map to a Java primitive array type.");
+
+        using std::vector<T>::vector;
+
+        array_of() = default;
+
+        array_of(const std::vector<T>& vec)
+            : std::vector<T>(vec)
+        {}
+
+        array_of(std::vector<T>&& vec)
+            : std::vector<T>(std::move(vec))
+        {}
+    };
+
+    /**
+     * Options that govern the conversion of large native containers into Java.
+     */
+    struct marshalling_options
+    {
+        /**
+         * Minimum number of elements for an object array to be populated by the workers of the shared native executor
+         * in parallel. Parallel conversion is disabled by default.
+         *
+         * Parallel conversion pays off only when creating an element is expensive compared to dispatching a task,
+         * e.g. for strings and records in arrays of hundreds of thousands of elements.
+         */
+        inline static std::atomic<std::size_t> parallel_threshold = std::numeric_limits<std::size_t>::max();
+    };
+
+    /**
+     * Converts a native vector into a Java object array type.
+     */
+    template <typename T>
+    struct JavaObjectArrayType
+    {
+        using native_type = array_of<T>;
+        using element_type = arg_type_t<T>;
+        using java_type = jobjectArray;
+
+    private:
+        constexpr static std::string_view array_type_prefix = "[";
+        constexpr static std::string_view array_type_suffix = "]";
+
+    public:
+        constexpr static std::string_view java_name = join_v<element_type::java_name, array_type_prefix, array_type_suffix>;
+        constexpr static std::string_view sig = join_v<array_type_prefix, element_type::sig>;
+        constexpr static std::string_view class_path = sig;
+
+        /** Local references held at the same time while converting an array, excluding those of nested conversions. */
+        constexpr static jint frame_capacity = 1 + local_capacity_v<T>;
+
+        /**
+         * Returns the element class, looked up only once.
+         */
+        static jclass element_class(JNIEnv* env)
+        {
+            static const GlobalClassRef cls(env, LocalClassRef(env, element_type::class_path));
+            return cls.ref();
+        }
+
+        static native_type native_value(JNIEnv* env, java_type arr)
+        {
+            if (arr == nullptr) {
+                throw JavaNullPointerException(env, msg() << java_name << " is null");
+            }
+            return with_local_frame(env, frame_capacity, [&]() {
+                jsize len = env->GetArrayLength(arr);
+                native_type vec;
+                vec.reserve(len);
+                for (jsize k = 0; k < len; ++k) {
+                    LocalObjectRef element(env, env->GetObjectArrayElement(arr, k));
+                    vec.push_back(element_type::native_value(env, static_cast<typename element_type::java_type>(element.ref())));
+                }
+                return vec;
+            });
+        }
+
+        static java_type java_value(JNIEnv* env, const native_type& vec)
+        {
+            jclass cls = element_class(env);
+            if (!vec.empty() && vec.size() >= marshalling_options::parallel_threshold.load(std::memory_order_relaxed) && !executor::is_worker_thread()) {
+                return parallel_java_value(env, cls, vec);
+            }
+            return with_local_frame(env, frame_capacity, [&]() {
+                jobjectArray arr = env->NewObjectArray(static_cast<jsize>(vec.size()), cls, nullptr);
+                if (arr == nullptr) {
+                    throw JavaException(env);
+                }
+                for (std::size_t k = 0; k < vec.size(); ++k) {
+                    LocalObjectRef element(env, element_type::java_value(env, vec[k]));
+                    env->SetObjectArrayElement(arr, static_cast<jsize>(k), element.ref());
+                }
+                return arr;
+            });
+        }
+
+        static native_type native_field_value(JNIEnv* env, jobject obj, Field& fld)
+        {
+            LocalObjectRef objFieldValue(env, env->GetObjectField(obj, fld.ref()));
+            return native_value(env, static_cast<java_type>(objFieldValue.ref()));
+        }
+
+        static void java_set_field_value(JNIEnv* env, jobject obj, Field& fld, const native_type& value)
+        {
+            LocalObjectRef objFieldValue(env, java_value(env, value));
+            env->SetObjectField(obj, fld.ref(), objFieldValue.ref());
+        }
+
+    private:
+        /**
+         * Stores elements in the range [first, last) into a Java array, creating Java objects in a local frame.
+         */
+        static void store_elements(JNIEnv* env, jobjectArray arr, const native_type& vec, std::size_t first, std::size_t last)
+        {
+            with_local_frame(env, frame_capacity, [&]() {
+                for (std::size_t k = first; k < last; ++k) {
+                    LocalObjectRef element(env, element_type::java_value(env, vec[k]));
+                    env->SetObjectArrayElement(arr, static_cast<jsize>(k), element.ref());
+                }
+            });
+        }
+
+        /**
+         * Partitions the vector across the workers of the shared executor and the calling thread, each of which creates
+         * Java objects for its partition, and stores them directly into an array shared via a global reference.
+         */
+        static java_type parallel_java_value(JNIEnv* env, jclass cls, const native_type& vec)
+        {
+            jobjectArray arr = env->NewObjectArray(static_cast<jsize>(vec.size()), cls, nullptr);
+            if (arr == nullptr) {
+                throw JavaException(env);
+            }
+            UniqueGlobalRef globalArr(env, arr);
+
+            // convert the first element on the calling thread such that classes and field bindings the conversion
+            // looks up once are resolved with the class loader of the caller rather than on a worker thread
+            try {
+                store_elements(env, arr, vec, 0, 1);
+            } catch (...) {
+                env->DeleteLocalRef(arr);
+                throw;
+            }
+
+            executor& pool = executor::shared();
+            std::size_t partitions = pool.size() + 1;
+            std::size_t chunk = (vec.size() + partitions - 1) / partitions;
+
+            // the calling thread converts the first partition while workers convert the rest
+            std::vector<std::future<void>> futures;
+            for (std::size_t first = chunk; first < vec.size(); first += chunk) {
+                std::size_t last = std::min(first + chunk, vec.size());
+                futures.push_back(pool.submit([&vec, &globalArr, first, last]() {
+                    store_elements(this_thread.getEnv(), static_cast<jobjectArray>(globalArr.ref()), vec, first, last);
+                }));
+            }
+
+            try {
+                store_elements(env, arr, vec, 1, std::min(chunk, vec.size()));
+            } catch (...) {
+                // partitions refer to the native vector, wait for them before unwinding
+                for (auto&& future : futures) {
+                    future.wait();
+                }
+                env->DeleteLocalRef(arr);
+                throw;
+            }
+
+            for (auto&& future : futures) {
+                future.wait();
+            }
+            try {
+                for (auto&& future : futures) {
+                    future.get();
+                }
+            } catch (...) {
+                env->DeleteLocalRef(arr);
+                throw;
+            }
+            return arr;
+        }
+    };
+
+    /**
+     * A dense two-dimensional array of arithmetic values stored contiguously in row-major order.
+     *
+     * Maps to a rectangular Java array of a primitive type such as `double[][]`.
+     */
+    template <typename T>
+    class matrix
+    {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Matrix elements must be of a non-boolean arithmetic type.");
+
+    public:
+        using value_type = T;
+
+        matrix() = default;
+
+        matrix(std::size_t rows, std::size_t cols)
+            : _rows(rows)
+            , _cols(cols)
+            , _data(rows * cols)
+        {}
+
+        matrix(std::size_t rows, std::size_t cols, std::vector<T>&& data)
+            : _rows(rows)
+            , _cols(cols)
+            , _data(std::move(data))
+        {
+            if (_data.size() != rows * cols) {
+                throw std::invalid_argument(msg() << "Matrix of shape " << rows << " x " << cols << " cannot hold " << _data.size() << " elements");
+            }
+        }
+
+        std::size_t rows() const
+        {
+            return _rows;
+        }
+
+        std::size_t cols() const
+        {
+            return _cols;
+        }
+
+        T& operator()(std::size_t row, std::size_t col)
+        {
+            return _data[row * _cols + col];
+        }
+
+        const T& operator()(std::size_t row, std::size_t col) const
+        {
+            return _data[row * _cols + col];
+        }
+
+        T* row(std::size_t row)
+        {
+            return _data.data() + row * _cols;
+        }
+
+        const T* row(std::size_t row) const
+        {
+            return _data.data() + row * _cols;
+        }
+
+        T* data()
+        {
+            return _data.data();
+        }
+
+        const T* data() const
+        {
+            return _data.data();
+        }
+
+        bool operator==(const matrix& op) const
+        {
+            return _rows == op._rows && _cols == op._cols && _data == op._data;
+        }
+
+        bool operator!=(const matrix& op) const
+        {
+            return !(*this == op);
+        }
+
+    private:
+        std::size_t _rows = 0;
+        std::size_t _cols = 0;
+        std::vector<T> _data;
+    };
+
+    /**
+     * Converts a native matrix into a rectangular two-dimensional Java primitive array, copying a row at a time.
+     */
+    template <typename T>
+    struct JavaMatrixType
+    {
+        using native_type = matrix<T>;
+        using element_type = arg_type_t<T>;
+        using java_type = jobjectArray;
+
+    private:
+        constexpr static std::string_view array_type_prefix = "[";
+        constexpr static std::string_view array_type_suffix = "]";
+        constexpr static std::string_view row_sig = join_v<array_type_prefix, element_type::sig>;
+
+    public:
+        constexpr static std::string_view java_name = join_v<element_type::java_name, array_type_prefix, array_type_suffix, array_type_prefix, array_type_suffix>;
+        constexpr static std::string_view sig = join_v<array_type_prefix, row_sig>;
+        constexpr static std::string_view class_path = sig;
+
+        /** Holds the outer array and a single row. */
+        constexpr static jint frame_capacity = 2;
+
+        /**
+         * Returns the class of a matrix row (e.g. `double[]`), looked up only once.
+         */
+        static jclass row_class(JNIEnv* env)
+        {
+            static const GlobalClassRef cls(env, LocalClassRef(env, row_sig));
+            return cls.ref();
+        }
+
+        static native_type native_value(JNIEnv* env, java_type arr)
+        {
+            if (arr == nullptr) {
+                throw JavaNullPointerException(env, msg() << java_name << " is null");
+            }
+            return with_local_frame(env, frame_capacity, [&]() {
+                std::size_t rows = env->GetArrayLength(arr);
+                if (rows == 0) {
+                    return native_type();
+                }
+
+                native_type mat;
+                for (std::size_t r = 0; r < rows; ++r) {
+                    LocalObjectRef row(env, env->GetObjectArrayElement(arr, static_cast<jsize>(r)));
+                    if (row.ref() == nullptr) {
+                        throw JavaNullPointerException(env, msg() << "row " << r << " of " << java_name << " is null");
+                    }
+                    std::size_t cols = env->GetArrayLength(static_cast<jarray>(row.ref()));
+                    if (r == 0) {
+                        mat = native_type(rows, cols);
+                    } else if (cols != mat.cols()) {
+                        throw std::invalid_argument(msg() << "row " << r << " of " << java_name << " has " << cols << " elements but row 0 has " << mat.cols());
+                    }
+                    element_type::native_array_value(env, static_cast<jarray>(row.ref()), mat.row(r), cols);
+                }
+                return mat;
+            });
+        }
+
+        static java_type java_value(JNIEnv* env, const native_type& mat)
+        {
+            jclass cls = row_class(env);
+            return with_local_frame(env, frame_capacity, [&]() {
+                jobjectArray arr = env->NewObjectArray(static_cast<jsize>(mat.rows()), cls, nullptr);
+                if (arr == nullptr) {
+                    throw JavaException(env);
+                }
+                for (std::size_t r = 0; r < mat.rows(); ++r) {
+                    LocalObjectRef row(env, element_type::java_array_value(env, mat.row(r), mat.cols()));
+                    env->SetObjectArrayElement(arr, static_cast<jsize>(r), row.ref());
+                }
+                return arr;
+            });
+        }
+
+        static native_type native_field_value(JNIEnv* env, jobject obj, Field& fld)
+        {
+            LocalObjectRef objFieldValue(env, env->GetObjectField(obj, fld.ref()));
+            return native_value(env, static_cast<java_type>(objFieldValue.ref()));
+        }
+
+        static void java_set_field_value(JNIEnv* env, jobject obj, Field& fld, const native_type& value)
+        {
+            LocalObjectRef objFieldValue(env, java_value(env, value));
+            env->SetObjectField(obj, fld.ref(), objFieldValue.ref());
+        }
+    };
+
+    template <typename T> struct ArgType<array_of<T>> { using type = JavaObjectArrayType<T>; };
+    template <typename T> struct ArgType<matrix<T>> { using type = JavaMatrixType<T>; };
+}
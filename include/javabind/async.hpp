@@ -0,0 +1,197 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "collection.hpp"
+#include "exception.hpp"
+#include "executor.hpp"
+#include "global.hpp"
+#include "signature.hpp"
+#include "traits.hpp"
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace javabind
+{
+    /**
+     * Stands for a `java.util.concurrent.CompletableFuture` that is completed with a value of type `T`.
+     *
+     * Used only as the return type in the signature of functions registered with `function_async`.
+     */
+    template <typename T>
+    struct completable_future
+    {};
+
+    template <typename T>
+    struct JavaCompletableFutureType
+    {
+        using java_type = jobject;
+
+        constexpr static std::string_view class_name = "java.util.concurrent.CompletableFuture";
+        constexpr static std::string_view java_name = GenericTraits<class_name, boxed_t<T>>::java_name;
+        constexpr static std::string_view sig = "Ljava/util/concurrent/CompletableFuture;";
+    };
+
+    template <>
+    struct JavaCompletableFutureType<void>
+    {
+        using java_type = jobject;
+
+        constexpr static std::string_view class_name = "java.util.concurrent.CompletableFuture";
+        constexpr static std::string_view java_name = "java.util.concurrent.CompletableFuture<java.lang.Void>";
+        constexpr static std::string_view sig = "Ljava/util/concurrent/CompletableFuture;";
+    };
+
+    template <typename T> struct ArgType<completable_future<T>> { using type = JavaCompletableFutureType<T>; };
+
+    /**
+     * Maps the signature of a native function to the signature of the Java method that returns a future.
+     */
+    template <typename F>
+    struct async_signature;
+
+    template <typename R, typename... Args>
+    struct async_signature<R(*)(Args...)>
+    {
+        using type = completable_future<R>(Args...);
+    };
+
+    template <typename F>
+    using async_signature_t = typename async_signature<F>::type;
+
+    template <typename T>
+    struct is_basic_string_view : std::false_type {};
+
+    template <typename C, typename Traits>
+    struct is_basic_string_view<std::basic_string_view<C, Traits>> : std::true_type {};
+
+    /**
+     * Classes and method identifiers used in completing a `CompletableFuture`, looked up once and shared across threads.
+     */
+    struct CompletableFutureSupport
+    {
+        static const CompletableFutureSupport& get(JNIEnv* env)
+        {
+            static const CompletableFutureSupport instance(env);
+            return instance;
+        }
+
+        GlobalClassRef futureClass;
+        Method initFunc;
+        Method completeFunc;
+        Method completeExceptionallyFunc;
+        GlobalClassRef exceptionClass;
+        Method exceptionInitFunc;
+
+    private:
+        CompletableFutureSupport(JNIEnv* env)
+            : futureClass(env, LocalClassRef(env, "java/util/concurrent/CompletableFuture"))
+            , initFunc(futureClass.getMethod(env, "<init>", "()V"))
+            , completeFunc(futureClass.getMethod(env, "complete", "(Ljava/lang/Object;)Z"))
+            , completeExceptionallyFunc(futureClass.getMethod(env, "completeExceptionally", "(Ljava/lang/Throwable;)Z"))
+            , exceptionClass(env, LocalClassRef(env, "java/lang/Exception"))
+            , exceptionInitFunc(exceptionClass.getMethod(env, "<init>", "(Ljava/lang/String;)V"))
+        {}
+    };
+
+    /**
+     * Wraps a native function pointer into a function pointer callable from Java that returns a `CompletableFuture`.
+     *
+     * Arguments are converted on the calling Java thread, and the function runs on the shared native executor. The
+     * future is completed on the worker thread, with the result or with the exception that the function raised.
+     */
+    template <auto func, typename... Args>
+    struct AsyncAdapter
+    {
+        template <typename T>
+        using java_t = typename arg_type_t<T>::java_type;
+
+        using result_type = decltype(func(std::declval<Args>()...));
+
+        static_assert(
+            (!is_basic_string_view<std::decay_t<Args>>::value && ...),
+            "Arguments of asynchronous functions must not refer to memory owned by Java, e.g. use std::string instead of std::string_view."
+        );
+
+        static_assert(
+            (!is_call_scoped<std::decay_t<Args>>::value && ...),
+            "Arguments of asynchronous functions must not be bound to the Java call, e.g. use std::function instead of function_view, or std::vector instead of pinned_array."
+        );
+
+        static jobject invoke(JNIEnv* env, jclass, java_t<std::decay_t<Args>>... args)
+        {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(invoke));
+            try {
+                const CompletableFutureSupport& support = CompletableFutureSupport::get(env);
+
+                // arguments are copied because the function runs after the Java call has returned
+                auto native_args = std::make_tuple(std::decay_t<Args>(arg_type_t<Args>::native_value(env, args))...);
+
+                jobject future = env->NewObject(support.futureClass.ref(), support.initFunc.ref());
+                if (future == nullptr) {
+                    throw JavaException(env);
+                }
+
+                executor::shared().post(
+                    [future = UniqueGlobalRef(env, future), native_args = std::move(native_args)]() mutable
+                    {
+                        complete(future.ref(), native_args);
+                    }
+                );
+                return future;
+            } catch (JavaException& ex) {
+                env->Throw(ex.innerException());
+                return nullptr;
+            } catch (std::exception& ex) {
+                exception_handler(env, ex);
+                return nullptr;
+            }
+        }
+
+    private:
+        template <typename Tuple>
+        static void complete(jobject future, Tuple& native_args)
+        {
+            JNIEnv* env = this_thread.getEnv();
+            if (env == nullptr) {
+                return;  // thread cannot be attached, future cannot be completed
+            }
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(invoke));
+            const CompletableFutureSupport& support = CompletableFutureSupport::get(env);
+
+            try {
+                if constexpr (!std::is_same_v<result_type, void>) {
+                    auto&& result = std::apply(func, native_args);
+                    LocalObjectRef value(env, arg_type_t<boxed_t<std::decay_t<result_type>>>::java_value(env, std::move(result)));
+                    env->CallBooleanMethod(future, support.completeFunc.ref(), value.ref());
+                } else {
+                    std::apply(func, native_args);
+                    env->CallBooleanMethod(future, support.completeFunc.ref(), nullptr);
+                }
+            } catch (JavaException& ex) {
+                env->CallBooleanMethod(future, support.completeExceptionallyFunc.ref(), ex.innerException());
+            } catch (std::exception& ex) {
+                env->ExceptionClear();
+                LocalObjectRef message(env, env->NewStringUTF(ex.what()));
+                LocalObjectRef exception(env, env->NewObject(support.exceptionClass.ref(), support.exceptionInitFunc.ref(), message.ref()));
+                env->CallBooleanMethod(future, support.completeExceptionallyFunc.ref(), exception.ref());
+            }
+        }
+    };
+
+    template <auto func, typename... Args>
+    constexpr void* async_callable(types<Args...>)
+    {
+        return reinterpret_cast<void*>(AsyncAdapter<func, Args...>::invoke);
+    }
+}
@@ -16,6 +16,15 @@
 #include "record.hpp"
 #include "function.hpp"
 #include "collection.hpp"
+#include "array.hpp"
+#include "async.hpp"
+#include "objects.hpp"
+#include "payload.hpp"
+#include "consumer.hpp"
+#include "dispatcher.hpp"
+#include "parallel.hpp"
+#include "stats.hpp"
+#include "stream.hpp"
 #include "optional.hpp"
 #include "enum.hpp"
 
@@ -62,12 +71,42 @@ namespace javabind
                 [](JNIEnv* env, jobject obj, Field& fld, void* native_object_ptr) {
                     T* native_object = reinterpret_cast<T*>(native_object_ptr);
                     native_object->*member = arg_type_t<member_type>::native_field_value(env, obj, fld);
-                }
+                },
+                local_capacity_v<member_type>
                 });
             return *this;
         }
     };
 
+    /**
+     * Converts a Java argument to a native value, attributing JNI calls to the type converter when accounted, and
+     * recording the size of the value when the call is sampled.
+     */
+    template <typename T>
+    decltype(auto) native_argument(JNIEnv* env, typename arg_type_t<T>::java_type value)
+    {
+        JNIAccounting::type_scope accounting(arg_type_t<T>::java_name);
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+        decltype(auto) native = arg_type_t<T>::native_value(env, value);
+        PayloadProfiler::argument(native);
+        return native;
+#else
+        return arg_type_t<T>::native_value(env, value);
+#endif
+    }
+
+    /**
+     * Converts a native result to a Java value, attributing JNI calls to the type converter when accounted, and
+     * recording the size of the value when the call is sampled.
+     */
+    template <typename T, typename V>
+    auto java_result(JNIEnv* env, V&& value)
+    {
+        JNIAccounting::type_scope accounting(arg_type_t<T>::java_name);
+        PayloadProfiler::result(value);
+        return arg_type_t<T>::java_value(env, std::forward<V>(value));
+    }
+
     /**
      * Wraps a native function pointer into a function pointer callable from Java.
      * Adapts a function with the signature R(*func)(Args...).
@@ -84,19 +123,27 @@ namespace javabind
 
         static java_t<result_type> invoke(JNIEnv* env, jclass, java_t<std::decay_t<Args>>... args)
         {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(invoke));
+            LocalRefTracker::frame_scope tracking(reinterpret_cast<const void*>(invoke));
+            statistics_scope scope(statistics_of<Adapter>());
+            PayloadProfiler::call_scope payload(payload_statistics_of<Adapter>());
             try {
                 if constexpr (!std::is_same_v<result_type, void>) {
-                    auto&& result = func(arg_type_t<Args>::native_value(env, args)...);
-                    return static_cast<java_t<result_type>>(arg_type_t<result_type>::java_value(env, std::move(result)));
+                    auto&& result = scope.invoke(func, native_argument<Args>(env, args)...);
+                    return tracking.handover(static_cast<java_t<result_type>>(java_result<result_type>(env, std::move(result))));
                 } else {
-                    func(arg_type_t<Args>::native_value(env, args)...);
+                    scope.invoke(func, native_argument<Args>(env, args)...);
                 }
             } catch (JavaException& ex) {
-                env->Throw(ex.innerException());
+                scope.failed();
+                env->Throw(tracking.handover(ex.innerException()));
                 if constexpr (!std::is_same_v<result_type, void>) {
                     return java_t<result_type>();
                 }
             } catch (std::exception& ex) {
+                scope.failed();
                 exception_handler(env, ex);
                 if constexpr (!std::is_same_v<result_type, void>) {
                     return java_t<result_type>();
@@ -121,6 +168,12 @@ namespace javabind
 
         static java_t<result_type> invoke(JNIEnv* env, jobject obj, java_t<std::decay_t<Args>>... args)
         {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(invoke));
+            LocalRefTracker::frame_scope tracking(reinterpret_cast<const void*>(invoke));
+            statistics_scope scope(statistics_of<MemberAdapter>());
+            PayloadProfiler::call_scope payload(payload_statistics_of<MemberAdapter>());
             try {
                 // look up field that stores native pointer
                 LocalClassRef cls(env, obj);
@@ -131,19 +184,24 @@ namespace javabind
                 if (!ptr) {
                     throw std::logic_error(msg() << "Object " << ClassTraits<T>::class_name << " has already been disposed of.");
                 }
+                auto&& body = [ptr](auto&&... native_args) -> result_type {
+                    return (ptr->*func)(std::forward<decltype(native_args)>(native_args)...);
+                };
                 if constexpr (!std::is_same_v<result_type, void>) {
-                    auto&& result = (ptr->*func)(arg_type_t<Args>::native_value(env, args)...);
-                    return arg_type_t<result_type>::java_value(env, std::move(result));
+                    auto&& result = scope.invoke(body, native_argument<Args>(env, args)...);
+                    return tracking.handover(java_result<result_type>(env, std::move(result)));
                 } else {
-                    (ptr->*func)(arg_type_t<Args>::native_value(env, args)...);
+                    scope.invoke(body, native_argument<Args>(env, args)...);
                 }
 
             } catch (JavaException& ex) {
-                env->Throw(ex.innerException());
+                scope.failed();
+                env->Throw(tracking.handover(ex.innerException()));
                 if constexpr (!std::is_same_v<result_type, void>) {
                     return java_t<result_type>();
                 }
             } catch (std::exception& ex) {
+                scope.failed();
                 exception_handler(env, ex);
                 if constexpr (!std::is_same_v<result_type, void>) {
                     return java_t<result_type>();
@@ -168,6 +226,19 @@ namespace javabind
         return reinterpret_cast<void*>(f);
     }
 
+    /**
+     * Returns the call statistics of the adapter that `callable` returns.
+     */
+    template <typename T, auto func, typename... Args>
+    BindingStatistics* callable_statistics(types<Args...>)
+    {
+        return &statistics_of<std::conditional_t<
+            std::is_member_function_pointer_v<decltype(func)>,
+            MemberAdapter<T, func, Args...>,
+            Adapter<func, Args...>
+        >>();
+    }
+
     /**
      * Adapts a constructor function to be invoked from Java on object instantiation with a class method.
      */
@@ -179,26 +250,28 @@ namespace javabind
 
         static jobject invoke(JNIEnv* env, jclass cls, java_t<Args>... args)
         {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(invoke));
+            LocalRefTracker::frame_scope tracking(reinterpret_cast<const void*>(invoke));
+            statistics_scope scope(statistics_of<CreateObjectAdapter>());
+            PayloadProfiler::call_scope payload(payload_statistics_of<CreateObjectAdapter>());
             try {
                 // instantiate native object
-                T* ptr = new T(arg_type_t<Args>::native_value(env, args)...);
+                std::unique_ptr<T> ptr = scope.invoke(
+                    [](auto&&... native_args) { return std::make_unique<T>(std::forward<decltype(native_args)>(native_args)...); },
+                    native_argument<Args>(env, args)...
+                );
 
-                // instantiate Java object by skipping constructor
                 LocalClassRef objClass(env, cls);
-                jobject obj = env->AllocObject(objClass.ref());
-                if (obj == nullptr) {
-                    throw JavaException(env);
-                }
-
-                // store native pointer in Java object field
-                Field field = objClass.getField("nativePointer", arg_type_t<T*>::sig);
-                arg_type_t<T*>::java_set_field_value(env, obj, field, ptr);
-
-                return obj;
+                jobject obj = NativeClassJavaType<T>::wrap_native_object(env, objClass, std::move(ptr));
+                return tracking.handover(obj);
             } catch (JavaException& ex) {
-                env->Throw(ex.innerException());
+                scope.failed();
+                env->Throw(tracking.handover(ex.innerException()));
                 return nullptr;
             } catch (std::exception& ex) {
+                scope.failed();
                 exception_handler(env, ex);
                 return nullptr;
             }
@@ -214,6 +287,10 @@ namespace javabind
     {
         static void invoke(JNIEnv* env, jobject obj)
         {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(invoke));
+            LocalRefTracker::frame_scope tracking(reinterpret_cast<const void*>(invoke));
             try {
                 // look up field that stores native pointer
                 LocalClassRef cls(env, obj);
@@ -221,12 +298,15 @@ namespace javabind
                 T* ptr = arg_type_t<T*>::native_field_value(env, obj, field);
 
                 // release native object
-                delete ptr;
+                if (ptr != nullptr) {
+                    delete ptr;
+                    NativeObjectCounters<T>::destroyed.fetch_add(1, std::memory_order_relaxed);
+                }
 
                 // prevent accidental duplicate delete
                 arg_type_t<T*>::java_set_field_value(env, obj, field, nullptr);
             } catch (JavaException& ex) {
-                env->Throw(ex.innerException());
+                env->Throw(tracking.handover(ex.innerException()));
             } catch (std::exception& ex) {
                 exception_handler(env, ex);
             }
@@ -239,6 +319,12 @@ namespace javabind
         return reinterpret_cast<void*>(CreateObjectAdapter<T, Args...>::invoke);
     }
 
+    template <typename T, typename... Args>
+    BindingStatistics* object_initialization_statistics(types<Args...>)
+    {
+        return &statistics_of<CreateObjectAdapter<T, Args...>>();
+    }
+
     template <typename T>
     constexpr void* object_termination()
     {
@@ -252,8 +338,73 @@ namespace javabind
         void* function_entry_point;
         std::string_view param_display;
         std::string_view return_display;
+        std::string_view param_names = "";
+        /** Call counters and timings, or `nullptr` if calls are not counted. */
+        BindingStatistics* statistics = nullptr;
+        bool offload = false;
+        bool traced = false;
+
+        /** Suffix of the name under which a function with a generated Java wrapper is registered as a native method. */
+        constexpr static std::string_view offload_suffix = "$native";
+
+        /** True if the generated Java method forwards to a private native method. */
+        bool has_wrapper() const
+        {
+            return offload || traced;
+        }
+
+        /** Name of the native method in Java. */
+        std::string native_name() const
+        {
+            std::string result(name);
+            if (has_wrapper()) {
+                result.append(offload_suffix);
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Binding option that moves a native call made from a Java virtual thread to a platform thread.
+     *
+     * A native call pins the carrier thread of a virtual thread. With this option, the Java method `name` forwards to
+     * the native method `name$native` via the bundled helper class `NativeOffload`, which runs the call on a platform
+     * thread and parks the virtual thread until the result is available. Calls from platform threads are not affected.
+     */
+    struct offload_t
+    {
+        explicit offload_t() = default;
+    };
+
+    inline constexpr offload_t offload{};
+
+    /**
+     * Binding option that reports native calls to Java Flight Recorder.
+     *
+     * With this option, the Java method `name` forwards to the native method `name$native`, and wraps the call in the
+     * bundled event `NativeCallEvent`, which records the binding name, the duration of the call and the total size of
+     * string, array, collection and map arguments. Argument sizes are computed only if the event is committed.
+     */
+    struct traced_t
+    {
+        explicit traced_t() = default;
     };
 
+    inline constexpr traced_t traced{};
+
+    namespace detail
+    {
+        inline void apply_binding_option(FunctionBinding& binding, offload_t)
+        {
+            binding.offload = true;
+        }
+
+        inline void apply_binding_option(FunctionBinding& binding, traced_t)
+        {
+            binding.traced = true;
+        }
+    }
+
     struct FunctionBindings {
         using key_type = std::string_view;
         using value_type = std::vector<FunctionBinding>;
@@ -291,7 +442,58 @@ namespace javabind
                     false,
                     callable<T, func>(args_t<func_type>{}),
                     FunctionTraits<func_type>::param_display,
-                    FunctionTraits<func_type>::return_display
+                    FunctionTraits<func_type>::return_display,
+                    FunctionTraits<func_type>::param_names,
+                    callable_statistics<T, func>(args_t<func_type>{})
+                }
+            );
+            return *this;
+        }
+
+        /**
+         * Registers a native function with binding options.
+         *
+         * @param name The name of the function in Java.
+         * @param options Any of `offload` (calls from Java virtual threads run on a platform thread) and `traced`
+         * (calls are reported to Java Flight Recorder).
+         */
+        template <auto func, typename Option, typename... Options>
+        static_class& function(const std::string_view& name, Option option, Options... options)
+        {
+            function<func>(name);
+            FunctionBinding& binding = FunctionBindings::value.at(ClassTraits<T>::class_name).back();
+            detail::apply_binding_option(binding, option);
+            (detail::apply_binding_option(binding, options), ...);
+            return *this;
+        }
+
+        /**
+         * Registers a native function that runs on the shared native executor.
+         *
+         * The function must have a corresponding static function declared in Java that returns a future:
+         * ```
+         * public static native CompletableFuture<Integer> computeAsync(int val, String str);
+         * ```
+         *
+         * @param name The name of the static function in Java.
+         */
+        template <auto func>
+        static_class& function_async(const std::string_view& name)
+        {
+            using func_type = decltype(func);
+            using sig_type = async_signature_t<func_type>;
+
+            static_assert(is_unbound_function_pointer<func_type>::value, "The template argument is expected to be an unbound function pointer type.");
+
+            auto&& bindings = FunctionBindings::value.at(ClassTraits<T>::class_name);
+            bindings.push_back(
+                {
+                    name,
+                    FunctionTraits<sig_type>::sig,
+                    false,
+                    async_callable<func>(args_t<func_type>{}),
+                    FunctionTraits<sig_type>::param_display,
+                    FunctionTraits<sig_type>::return_display
                 }
             );
             return *this;
@@ -312,6 +514,9 @@ namespace javabind
             if (!result.second) {
                 throw std::runtime_error(msg() << "Native class '" << ClassTraits<T>::class_name << "' is defined more than once in C++ code");
             }
+            NativeObjectRegistry::value.emplace(ClassTraits<T>::class_name, []() {
+                return NativeObjectCounters<T>::get(ClassTraits<T>::class_name);
+            });
 
             auto&& bindings = result.first->second;
             bindings.push_back(
@@ -354,7 +559,9 @@ namespace javabind
                     false,
                     object_initialization<T>(args_t<F>{}),
                     FunctionTraits<F>::param_display,
-                    FunctionTraits<F>::return_display
+                    FunctionTraits<F>::return_display,
+                    "",
+                    object_initialization_statistics<T>(args_t<F>{})
                 }
             );
             return *this;
@@ -391,7 +598,58 @@ namespace javabind
                     is_member,
                     callable<T, func>(args_t<func_type>{}),
                     FunctionTraits<func_type>::param_display,
-                    FunctionTraits<func_type>::return_display
+                    FunctionTraits<func_type>::return_display,
+                    FunctionTraits<func_type>::param_names,
+                    callable_statistics<T, func>(args_t<func_type>{})
+                }
+            );
+            return *this;
+        }
+
+        /**
+         * Registers a native function with binding options.
+         *
+         * @param name The name of the function in Java.
+         * @param options Any of `offload` (calls from Java virtual threads run on a platform thread) and `traced`
+         * (calls are reported to Java Flight Recorder).
+         */
+        template <auto func, typename Option, typename... Options>
+        native_class& function(const std::string_view& name, Option option, Options... options)
+        {
+            function<func>(name);
+            FunctionBinding& binding = FunctionBindings::value.at(ClassTraits<T>::class_name).back();
+            detail::apply_binding_option(binding, option);
+            (detail::apply_binding_option(binding, options), ...);
+            return *this;
+        }
+
+        /**
+         * Registers a static native function that runs on the shared native executor.
+         *
+         * The function must have a corresponding static function declared in Java that returns a future:
+         * ```
+         * public static native CompletableFuture<Integer> computeAsync(int val, String str);
+         * ```
+         *
+         * @param name The name of the static function in Java.
+         */
+        template <auto func>
+        native_class& function_async(const std::string_view& name)
+        {
+            using func_type = decltype(func);
+            using sig_type = async_signature_t<func_type>;
+
+            static_assert(is_unbound_function_pointer<func_type>::value, "The template argument is expected to be an unbound function pointer type.");
+
+            auto&& bindings = FunctionBindings::value.at(ClassTraits<T>::class_name);
+            bindings.push_back(
+                {
+                    name,
+                    FunctionTraits<sig_type>::sig,
+                    false,
+                    async_callable<func>(args_t<func_type>{}),
+                    FunctionTraits<sig_type>::param_display,
+                    FunctionTraits<sig_type>::return_display
                 }
             );
             return *this;
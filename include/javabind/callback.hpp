@@ -13,6 +13,10 @@
 #include "type.hpp"
 #include "exception.hpp"
 #include "message.hpp"
+#include "stream.hpp"
+#include <algorithm>
+#include <string>
+#include <string_view>
 
 namespace javabind
 {
@@ -25,6 +29,9 @@ namespace javabind
 
         static return_type invoke(JNIEnv* env, jobject obj, arg_type arg)
         {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(invoke));
             try {
                 LocalClassRef cls(env, obj);
                 Field field = cls.getField("nativePointer", arg_type_t<callback_type*>::sig);
@@ -59,6 +66,7 @@ namespace javabind
                 }
             };
             rc = env->RegisterNatives(cls.ref(), methods, static_cast<jint>(std::size(methods)));
+            name(methods, std::size(methods), "hu/info/hunyadi/javabind/NativeCallback");
         }
 
         template <typename R, typename T>
@@ -84,6 +92,44 @@ namespace javabind
                 }
             };
             rc = env->RegisterNatives(cls.ref(), methods, static_cast<jint>(std::size(methods)));
+            name(methods, std::size(methods), callback_type::native_class_path);
+            return *this;
+        }
+
+        /**
+         * Registers native functions that feed elements of native streams to Java.
+         */
+        CallbackRegistry& add_stream()
+        {
+            if (rc != JNI_OK) {
+                return *this;
+            }
+
+            LocalClassRef cls(env, "hu/info/hunyadi/javabind/NativeSpliterator", std::nothrow);
+            if (cls.ref() == nullptr) {
+                javabind::throw_exception(env, "Cannot find Java class definition for native spliterator");
+                rc = JNI_ERR;
+                return *this;
+            }
+            JNINativeMethod methods[] = {
+                {
+                    const_cast<char*>("fetch"),
+                    const_cast<char*>("(JI)[Ljava/lang/Object;"),
+                    reinterpret_cast<void*>(StreamHandler::fetch)
+                },
+                {
+                    const_cast<char*>("split"),
+                    const_cast<char*>("(J)J"),
+                    reinterpret_cast<void*>(StreamHandler::split)
+                },
+                {
+                    const_cast<char*>("remaining"),
+                    const_cast<char*>("(J)J"),
+                    reinterpret_cast<void*>(StreamHandler::remaining)
+                }
+            };
+            rc = env->RegisterNatives(cls.ref(), methods, static_cast<jint>(std::size(methods)));
+            name(methods, std::size(methods), "hu/info/hunyadi/javabind/NativeSpliterator");
             return *this;
         }
 
@@ -93,6 +139,21 @@ namespace javabind
         }
 
     private:
+        /**
+         * Associates human-readable names with native functions of a bundled helper class, used in accounting for
+         * the JNI calls that they make.
+         */
+        static void name([[maybe_unused]] const JNINativeMethod* methods, [[maybe_unused]] std::size_t count, [[maybe_unused]] std::string_view class_path)
+        {
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            std::string class_name(class_path);
+            std::replace(class_name.begin(), class_name.end(), '/', '.');
+            for (std::size_t i = 0; i < count; ++i) {
+                JNIAccounting::name(methods[i].fnPtr, msg() << class_name << "." << methods[i].name);
+            }
+#endif
+        }
+
         JNIEnv* env;
         jint rc;
     };
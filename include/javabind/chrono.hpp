@@ -72,6 +72,8 @@ namespace javabind
         using native_type = T;
         using java_type = jobject;
 
+        constexpr static jint local_capacity = 2;
+
         static native_type native_value(JNIEnv* env, java_type javaValue)
         {
             if (javaValue == nullptr) {
@@ -96,6 +98,8 @@ namespace javabind
         using native_type = T;
         using java_type = jobject;
 
+        constexpr static jint local_capacity = 2;
+
         static native_type native_value(JNIEnv* env, java_type javaValue)
         {
             if (javaValue == nullptr) {
@@ -10,6 +10,9 @@
 
 #pragma once
 #include "object.hpp"
+#include "objects.hpp"
+#include <atomic>
+#include <memory>
 
 namespace javabind
 {
@@ -23,6 +26,8 @@ namespace javabind
     template <typename T>
     struct NativeClassJavaType : AssignableJavaType<T>
     {
+        constexpr static jint local_capacity = 2;
+
         static T& native_value(JNIEnv* env, jobject obj)
         {
             // look up field that stores native pointer
@@ -36,18 +41,29 @@ namespace javabind
         static jobject java_value(JNIEnv* env, U&& native_object)
         {
             // instantiate native object using copy or move constructor
-            T* ptr = new T(std::forward<U>(native_object));
+            auto ptr = std::make_unique<T>(std::forward<U>(native_object));
 
-            // instantiate Java object by skipping constructor
             LocalClassRef objClass(env, NativeClassJavaType<T>::class_path);
+            return wrap_native_object(env, objClass, std::move(ptr));
+        }
+
+        /**
+         * Stores a newly instantiated native object in a new instance of a Java class, and counts it as created.
+         * Takes ownership of the native object, which is deleted unless it has been stored in the Java object.
+         */
+        static jobject wrap_native_object(JNIEnv* env, LocalClassRef& objClass, std::unique_ptr<T>&& ptr)
+        {
+            // instantiate Java object by skipping constructor
             jobject obj = env->AllocObject(objClass.ref());
             if (obj == nullptr) {
                 throw JavaException(env);
             }
 
-            // store native pointer in Java object field
+            // store native pointer in Java object field, ownership passes to the Java object once the field is set
             Field field = objClass.getField("nativePointer", arg_type_t<T*>::sig);
-            arg_type_t<T*>::java_set_field_value(env, obj, field, ptr);
+            arg_type_t<T*>::java_set_field_value(env, obj, field, ptr.get());
+            ptr.release();
+            NativeObjectCounters<T>::created.fetch_add(1, std::memory_order_relaxed);
 
             return obj;
         }
@@ -9,6 +9,7 @@
  */
 
 #pragma once
+#include "global.hpp"
 #include "object.hpp"
 #include "signature.hpp"
 #include <vector>
@@ -47,7 +48,8 @@ namespace javabind
         T get(std::size_t i) const
         {
             LocalObjectRef listElement(env, env->CallObjectMethod(javaList, getFunc.ref(), static_cast<jint>(i)));
-            return arg_type_t<T>::native_value(env, listElement.ref());
+            using java_elem_type = arg_type_t<T>;
+            return java_elem_type::native_value(env, static_cast<typename java_elem_type::java_type>(listElement.ref()));
         }
 
     private:
@@ -57,35 +59,140 @@ namespace javabind
         Method getFunc;
     };
 
+    /**
+     * Classes and method identifiers used in traversing Java collections, looked up once and shared across threads.
+     *
+     * Elements are copied from a Java iterator into arrays by the bundled helper class `NativeIterators`, transferring
+     * a batch of elements in a single native-to-Java transition. The helper drains the collection through its own
+     * iterator, which preserves the semantics of concurrent and lazily evaluated collections. If the helper class is
+     * not visible to the class loader, traversal falls back to calling `hasNext` and `next` for each element.
+     */
+    struct CollectionSupport
+    {
+        /** Maximum number of elements transferred in a single native-to-Java transition. */
+        constexpr static jsize batch_size = 256;
+
+        static const CollectionSupport& get(JNIEnv* env)
+        {
+            static const CollectionSupport instance(env);
+            return instance;
+        }
+
+        bool has_drain() const
+        {
+            return drainFunc.ref() != nullptr;
+        }
+
+        /** Allocates an array that receives a batch of elements, or returns a null reference if batching is not available. */
+        LocalObjectRef new_buffer(JNIEnv* env) const
+        {
+            if (!has_drain()) {
+                return LocalObjectRef();
+            }
+            jobjectArray arr = env->NewObjectArray(batch_size, objectClass.ref(), nullptr);
+            if (arr == nullptr) {
+                throw JavaException(env);
+            }
+            return LocalObjectRef(env, arr);
+        }
+
+        GlobalClassRef objectClass;
+        GlobalClassRef helperClass;
+        StaticMethod drainFunc;
+        StaticMethod drainEntriesFunc;
+        Method iteratorFunc;
+        Method entrySetFunc;
+        Method hasNextFunc;
+        Method nextFunc;
+        Method getKeyFunc;
+        Method getValueFunc;
+
+    private:
+        CollectionSupport(JNIEnv* env)
+            : objectClass(env, LocalClassRef(env, "java/lang/Object"))
+            , helperClass(env, find_helper_class(env))
+            , drainFunc(find_static_method(env, helperClass, "drain", "(Ljava/util/Iterator;[Ljava/lang/Object;)I"))
+            , drainEntriesFunc(find_static_method(env, helperClass, "drainEntries", "(Ljava/util/Iterator;[Ljava/lang/Object;[Ljava/lang/Object;)I"))
+            , iteratorFunc(LocalClassRef(env, "java/util/Collection").getMethod("iterator", "()Ljava/util/Iterator;"))
+            , entrySetFunc(LocalClassRef(env, "java/util/Map").getMethod("entrySet", "()Ljava/util/Set;"))
+            , hasNextFunc(LocalClassRef(env, "java/util/Iterator").getMethod("hasNext", FunctionTraits<bool()>::sig))
+            , nextFunc(LocalClassRef(env, "java/util/Iterator").getMethod("next", FunctionTraits<object()>::sig))
+            , getKeyFunc(LocalClassRef(env, "java/util/Map$Entry").getMethod("getKey", FunctionTraits<object()>::sig))
+            , getValueFunc(LocalClassRef(env, "java/util/Map$Entry").getMethod("getValue", FunctionTraits<object()>::sig))
+        {}
+
+        static LocalClassRef find_helper_class(JNIEnv* env)
+        {
+            LocalClassRef cls(env, "hu/info/hunyadi/javabind/NativeIterators", std::nothrow);
+            if (cls.ref() == nullptr) {
+                env->ExceptionClear();
+            }
+            return cls;
+        }
+
+        static StaticMethod find_static_method(JNIEnv* env, const GlobalClassRef& cls, const char* name, const std::string_view& signature)
+        {
+            if (cls.ref() == nullptr) {
+                return StaticMethod();
+            }
+            return cls.getStaticMethod(env, name, signature);
+        }
+    };
+
     template <typename T>
     struct set_view_iterator
     {
         set_view_iterator(JNIEnv* env, LocalObjectRef&& setIterator)
             : env(env)
+            , support(CollectionSupport::get(env))
             , setIterator(std::move(setIterator))
+            , elements(support.new_buffer(env))
         {
-            LocalClassRef iteratorClass(env, "java/util/Iterator");
-            hasNextFunc = iteratorClass.getMethod("hasNext", FunctionTraits<bool()>::sig);
-            nextFunc = iteratorClass.getMethod("next", FunctionTraits<object()>::sig);
         }
 
-        bool has_next() const
+        bool has_next()
         {
-            return static_cast<bool>(env->CallBooleanMethod(setIterator.ref(), hasNextFunc.ref()));
+            if (!support.has_drain()) {
+                return static_cast<bool>(env->CallBooleanMethod(setIterator.ref(), support.hasNextFunc.ref()));
+            }
+
+            if (index < count) {
+                return true;
+            }
+            if (exhausted) {
+                return false;
+            }
+
+            count = env->CallStaticIntMethod(support.helperClass.ref(), support.drainFunc.ref(), setIterator.ref(), elements.ref());
+            if (env->ExceptionCheck()) {
+                throw JavaException(env);
+            }
+            index = 0;
+            exhausted = count < CollectionSupport::batch_size;
+            return count > 0;
         }
 
-        T get_next() const
+        T get_next()
         {
-            LocalObjectRef element(env, env->CallObjectMethod(setIterator.ref(), nextFunc.ref()));
+            jobject ref;
+            if (support.has_drain()) {
+                ref = env->GetObjectArrayElement(static_cast<jobjectArray>(elements.ref()), index++);
+            } else {
+                ref = env->CallObjectMethod(setIterator.ref(), support.nextFunc.ref());
+            }
+            LocalObjectRef element(env, ref);
             using java_elem_type = arg_type_t<T>;
             return java_elem_type::native_value(env, static_cast<typename java_elem_type::java_type>(element.ref()));
         }
 
     private:
         JNIEnv* env;
+        const CollectionSupport& support;
         LocalObjectRef setIterator;
-        Method hasNextFunc;
-        Method nextFunc;
+        LocalObjectRef elements;
+        jsize index = 0;
+        jsize count = 0;
+        bool exhausted = false;
     };
 
     /**
@@ -104,9 +211,8 @@ namespace javabind
 
         set_view_iterator<T> iterator() const
         {
-            LocalClassRef setClass(env, javaSet);
-            Method iteratorFunc = setClass.getMethod("iterator", "()Ljava/util/Iterator;");
-            return set_view_iterator<T>(env, LocalObjectRef(env, env->CallObjectMethod(javaSet, iteratorFunc.ref())));
+            const CollectionSupport& support = CollectionSupport::get(env);
+            return set_view_iterator<T>(env, LocalObjectRef(env, env->CallObjectMethod(javaSet, support.iteratorFunc.ref())));
         }
 
     private:
@@ -132,28 +238,53 @@ namespace javabind
     {
         map_view_iterator(JNIEnv* env, LocalObjectRef&& mapIterator)
             : env(env)
+            , support(CollectionSupport::get(env))
             , mapIterator(std::move(mapIterator))
+            , keys(support.new_buffer(env))
+            , values(support.new_buffer(env))
         {
-            LocalClassRef iteratorClass(env, "java/util/Iterator");
-            hasNextFunc = iteratorClass.getMethod("hasNext", FunctionTraits<bool()>::sig);
-            nextFunc = iteratorClass.getMethod("next", FunctionTraits<object()>::sig);
-
-            LocalClassRef entryClass(env, "java/util/Map$Entry");
-            getKeyFunc = entryClass.getMethod("getKey", FunctionTraits<object()>::sig);
-            getValueFunc = entryClass.getMethod("getValue", FunctionTraits<object()>::sig);
         }
 
-        bool has_next() const
+        bool has_next()
         {
-            return static_cast<bool>(env->CallBooleanMethod(mapIterator.ref(), hasNextFunc.ref()));
+            if (!support.has_drain()) {
+                return static_cast<bool>(env->CallBooleanMethod(mapIterator.ref(), support.hasNextFunc.ref()));
+            }
+
+            if (index < count) {
+                return true;
+            }
+            if (exhausted) {
+                return false;
+            }
+
+            count = env->CallStaticIntMethod(support.helperClass.ref(), support.drainEntriesFunc.ref(), mapIterator.ref(), keys.ref(), values.ref());
+            if (env->ExceptionCheck()) {
+                throw JavaException(env);
+            }
+            index = 0;
+            exhausted = count < CollectionSupport::batch_size;
+            return count > 0;
         }
 
-        map_entry<K, V> get_next() const
+        map_entry<K, V> get_next()
         {
-            LocalObjectRef entry(env, env->CallObjectMethod(mapIterator.ref(), nextFunc.ref()));
-            LocalObjectRef javaKey(env, env->CallObjectMethod(entry.ref(), getKeyFunc.ref()));
-            LocalObjectRef javaValue(env, env->CallObjectMethod(entry.ref(), getValueFunc.ref()));
+            if (support.has_drain()) {
+                LocalObjectRef javaKey(env, env->GetObjectArrayElement(static_cast<jobjectArray>(keys.ref()), index));
+                LocalObjectRef javaValue(env, env->GetObjectArrayElement(static_cast<jobjectArray>(values.ref()), index));
+                ++index;
+                return make_entry(javaKey, javaValue);
+            } else {
+                LocalObjectRef entry(env, env->CallObjectMethod(mapIterator.ref(), support.nextFunc.ref()));
+                LocalObjectRef javaKey(env, env->CallObjectMethod(entry.ref(), support.getKeyFunc.ref()));
+                LocalObjectRef javaValue(env, env->CallObjectMethod(entry.ref(), support.getValueFunc.ref()));
+                return make_entry(javaKey, javaValue);
+            }
+        }
 
+    private:
+        map_entry<K, V> make_entry(const LocalObjectRef& javaKey, const LocalObjectRef& javaValue) const
+        {
             using java_key_type = arg_type_t<K>;
             using java_value_type = arg_type_t<V>;
 
@@ -163,13 +294,14 @@ namespace javabind
             return map_entry<K, V>(std::move(nativeKey), std::move(nativeValue));
         }
 
-    private:
         JNIEnv* env;
+        const CollectionSupport& support;
         LocalObjectRef mapIterator;
-        Method hasNextFunc;
-        Method nextFunc;
-        Method getKeyFunc;
-        Method getValueFunc;
+        LocalObjectRef keys;
+        LocalObjectRef values;
+        jsize index = 0;
+        jsize count = 0;
+        bool exhausted = false;
     };
 
     /**
@@ -188,14 +320,9 @@ namespace javabind
 
         map_view_iterator<K, V> iterator() const
         {
-            LocalClassRef mapClass(env, javaMap);
-            Method entrySetFunc = mapClass.getMethod("entrySet", "()Ljava/util/Set;");
-
-            LocalClassRef entrySetClass(env, "java/util/Set");
-            Method iteratorFunc = entrySetClass.getMethod("iterator", "()Ljava/util/Iterator;");
-
-            LocalObjectRef entrySet(env, env->CallObjectMethod(javaMap, entrySetFunc.ref()));
-            LocalObjectRef mapIterator(env, env->CallObjectMethod(entrySet.ref(), iteratorFunc.ref()));
+            const CollectionSupport& support = CollectionSupport::get(env);
+            LocalObjectRef entrySet(env, env->CallObjectMethod(javaMap, support.entrySetFunc.ref()));
+            LocalObjectRef mapIterator(env, env->CallObjectMethod(entrySet.ref(), support.iteratorFunc.ref()));
 
             return map_view_iterator<K, V>(env, std::move(mapIterator));
         }
@@ -263,32 +390,42 @@ namespace javabind
         constexpr static std::string_view class_name = ClassTraits<T>::class_name;
         constexpr static std::string_view java_name = ClassTraits<T>::java_name;
 
+        /** Local references held at the same time while converting a list, excluding those of nested conversions. */
+        constexpr static jint frame_capacity = 2 + local_capacity_v<element_type>;
+
         static native_type native_value(JNIEnv* env, java_type javaList)
         {
             if (javaList == nullptr) {
                 throw JavaNullPointerException(env, msg() << java_name << " is null");
             }
-            list_view<element_type> view(env, javaList);
-            native_type nativeList;
-            std::size_t size = view.size();
-            for (std::size_t i = 0; i < size; i++) {
-                nativeList.push_back(view.get(i));
-            }
-            return nativeList;
+            return with_local_frame(env, frame_capacity, [&]() {
+                list_view<element_type> view(env, javaList);
+                native_type nativeList;
+                std::size_t size = view.size();
+                for (std::size_t i = 0; i < size; i++) {
+                    nativeList.push_back(view.get(i));
+                }
+                return nativeList;
+            });
         }
 
         static java_type java_value(JNIEnv* env, const native_type& nativeList)
         {
-            LocalClassRef arrayListClass(env, ClassTraits<native_type>::concrete_class_path);
-            Method initFunc = arrayListClass.getMethod("<init>", FunctionTraits<void(int)>::sig);
-            jobject arrayList = env->NewObject(arrayListClass.ref(), initFunc.ref(), nativeList.size());
-            Method addFunc = arrayListClass.getMethod("add", FunctionTraits<bool(object)>::sig);
-
-            for (auto&& element : nativeList) {
-                LocalObjectRef arrayListElement(env, arg_type_t<element_type>::java_value(env, element));
-                env->CallBooleanMethod(arrayList, addFunc.ref(), arrayListElement.ref());
-            }
-            return arrayList;
+            return with_local_frame(env, frame_capacity, [&]() {
+                LocalClassRef arrayListClass(env, ClassTraits<native_type>::concrete_class_path);
+                Method initFunc = arrayListClass.getMethod("<init>", FunctionTraits<void(int)>::sig);
+                jobject arrayList = env->NewObject(arrayListClass.ref(), initFunc.ref(), nativeList.size());
+                if (arrayList == nullptr) {
+                    throw JavaException(env);
+                }
+                Method addFunc = arrayListClass.getMethod("add", FunctionTraits<bool(object)>::sig);
+
+                for (auto&& element : nativeList) {
+                    LocalObjectRef arrayListElement(env, arg_type_t<element_type>::java_value(env, element));
+                    env->CallBooleanMethod(arrayList, addFunc.ref(), arrayListElement.ref());
+                }
+                return arrayList;
+            });
         }
     };
 
@@ -308,35 +445,42 @@ namespace javabind
         constexpr static std::string_view class_path = ClassTraits<native_boxed_type>::class_path;
         constexpr static std::string_view java_name = ClassTraits<native_boxed_type>::java_name;
 
+        /** Local references held at the same time while converting a set, excluding those of nested conversions. */
+        constexpr static jint frame_capacity = 3 + local_capacity_v<element_type>;
+
         static native_type native_value(JNIEnv* env, java_type javaSet)
         {
             if (javaSet == nullptr) {
                 throw JavaNullPointerException(env, msg() << java_name << " is null");
             }
-            set_view<element_type> view(env, javaSet);
-            set_view_iterator<element_type> iterator = view.iterator();
-            native_type nativeSet;
-            while (iterator.has_next()) {
-                nativeSet.insert(iterator.get_next());
-            }
-            return nativeSet;
+            return with_local_frame(env, frame_capacity, [&]() {
+                set_view<element_type> view(env, javaSet);
+                set_view_iterator<element_type> iterator = view.iterator();
+                native_type nativeSet;
+                while (iterator.has_next()) {
+                    nativeSet.insert(iterator.get_next());
+                }
+                return nativeSet;
+            });
         }
 
         static java_type java_value(JNIEnv* env, const native_type& nativeSet)
         {
-            LocalClassRef setClass(env, ClassTraits<native_type>::concrete_class_path);
-            Method initFunc = setClass.getMethod("<init>", FunctionTraits<void()>::sig);
-            Method addFunc = setClass.getMethod("add", FunctionTraits<bool(object)>::sig);
-            jobject javaSet = env->NewObject(setClass.ref(), initFunc.ref());
-            if (javaSet == nullptr) {
-                throw JavaException(env);
-            }
-
-            for (auto&& item : nativeSet) {
-                LocalObjectRef element(env, arg_type_t<element_type>::java_value(env, item));
-                env->CallBooleanMethod(javaSet, addFunc.ref(), element.ref());
-            }
-            return javaSet;
+            return with_local_frame(env, frame_capacity, [&]() {
+                LocalClassRef setClass(env, ClassTraits<native_type>::concrete_class_path);
+                Method initFunc = setClass.getMethod("<init>", FunctionTraits<void()>::sig);
+                Method addFunc = setClass.getMethod("add", FunctionTraits<bool(object)>::sig);
+                jobject javaSet = env->NewObject(setClass.ref(), initFunc.ref());
+                if (javaSet == nullptr) {
+                    throw JavaException(env);
+                }
+
+                for (auto&& item : nativeSet) {
+                    LocalObjectRef element(env, arg_type_t<element_type>::java_value(env, item));
+                    env->CallBooleanMethod(javaSet, addFunc.ref(), element.ref());
+                }
+                return javaSet;
+            });
         }
     };
 
@@ -357,37 +501,44 @@ namespace javabind
         constexpr static std::string_view class_path = ClassTraits<native_boxed_type>::class_path;
         constexpr static std::string_view java_name = ClassTraits<native_boxed_type>::java_name;
 
+        /** Local references held at the same time while converting a map, excluding those of nested conversions. */
+        constexpr static jint frame_capacity = 3 + local_capacity_v<key_type> + local_capacity_v<value_type>;
+
         static native_type native_value(JNIEnv* env, java_type javaMap)
         {
             if (javaMap == nullptr) {
                 throw JavaNullPointerException(env, msg() << java_name << " is null");
             }
-            map_view<key_type, value_type> view(env, javaMap);
-            map_view_iterator<key_type, value_type> iterator = view.iterator();
-            native_type nativeMap;
-            while (iterator.has_next()) {
-                auto item = iterator.get_next();
-                nativeMap[std::move(item.key)] = std::move(item.value);
-            }
-            return nativeMap;
+            return with_local_frame(env, frame_capacity, [&]() {
+                map_view<key_type, value_type> view(env, javaMap);
+                map_view_iterator<key_type, value_type> iterator = view.iterator();
+                native_type nativeMap;
+                while (iterator.has_next()) {
+                    auto item = iterator.get_next();
+                    nativeMap[std::move(item.key)] = std::move(item.value);
+                }
+                return nativeMap;
+            });
         }
 
         static java_type java_value(JNIEnv* env, const native_type& nativeMap)
         {
-            LocalClassRef mapClass(env, ClassTraits<native_type>::concrete_class_path);
-            Method initFunc = mapClass.getMethod("<init>", FunctionTraits<void()>::sig);
-            Method putFunc = mapClass.getMethod("put", FunctionTraits<object(object, object)>::sig);
-            jobject javaMap = env->NewObject(mapClass.ref(), initFunc.ref(), nativeMap.size());
-            if (javaMap == nullptr) {
-                throw JavaException(env);
-            }
-
-            for (auto&& item : nativeMap) {
-                LocalObjectRef key(env, arg_type_t<key_type>::java_value(env, item.first));
-                LocalObjectRef value(env, arg_type_t<value_type>::java_value(env, item.second));
-                env->CallObjectMethod(javaMap, putFunc.ref(), key.ref(), value.ref());
-            }
-            return javaMap;
+            return with_local_frame(env, frame_capacity, [&]() {
+                LocalClassRef mapClass(env, ClassTraits<native_type>::concrete_class_path);
+                Method initFunc = mapClass.getMethod("<init>", FunctionTraits<void()>::sig);
+                Method putFunc = mapClass.getMethod("put", FunctionTraits<object(object, object)>::sig);
+                jobject javaMap = env->NewObject(mapClass.ref(), initFunc.ref());
+                if (javaMap == nullptr) {
+                    throw JavaException(env);
+                }
+
+                for (auto&& item : nativeMap) {
+                    LocalObjectRef key(env, arg_type_t<key_type>::java_value(env, item.first));
+                    LocalObjectRef value(env, arg_type_t<value_type>::java_value(env, item.second));
+                    LocalObjectRef previous(env, env->CallObjectMethod(javaMap, putFunc.ref(), key.ref(), value.ref()));
+                }
+                return javaMap;
+            });
         }
     };
 
@@ -0,0 +1,202 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "collection.hpp"
+#include "global.hpp"
+#include "signature.hpp"
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <vector>
+
+namespace javabind
+{
+    /**
+     * Classes and method identifiers used in delivering batches of elements to a Java `Consumer`, looked up once and
+     * shared across threads.
+     *
+     * Batches are unrolled onto the consumer by the bundled helper class `NativeConsumers`. If the helper class is not
+     * visible to the class loader, elements are passed to the consumer one by one.
+     */
+    struct ConsumerSupport
+    {
+        static const ConsumerSupport& get(JNIEnv* env)
+        {
+            static const ConsumerSupport instance(env);
+            return instance;
+        }
+
+        bool has_accept_all() const
+        {
+            return acceptAllFunc.ref() != nullptr;
+        }
+
+        GlobalClassRef objectClass;
+        GlobalClassRef helperClass;
+        StaticMethod acceptAllFunc;
+        Method acceptFunc;
+
+    private:
+        ConsumerSupport(JNIEnv* env)
+            : objectClass(env, LocalClassRef(env, "java/lang/Object"))
+            , helperClass(env, find_helper_class(env))
+            , acceptAllFunc(find_accept_all(env, helperClass))
+            , acceptFunc(LocalClassRef(env, "java/util/function/Consumer").getMethod("accept", FunctionTraits<void(object)>::sig))
+        {}
+
+        static LocalClassRef find_helper_class(JNIEnv* env)
+        {
+            LocalClassRef cls(env, "hu/info/hunyadi/javabind/NativeConsumers", std::nothrow);
+            if (cls.ref() == nullptr) {
+                env->ExceptionClear();
+            }
+            return cls;
+        }
+
+        static StaticMethod find_accept_all(JNIEnv* env, const GlobalClassRef& cls)
+        {
+            if (cls.ref() == nullptr) {
+                return StaticMethod();
+            }
+            return cls.getStaticMethod(env, "acceptAll", "(Ljava/util/function/Consumer;[Ljava/lang/Object;I)V");
+        }
+    };
+
+    /**
+     * A native sink that delivers elements to a Java `Consumer` in batches.
+     *
+     * Elements are buffered natively, and passed to Java as an array in a single call when the buffer is full or when
+     * `flush` is called. Call `flush` before the native function returns, such that an exception raised by the
+     * consumer propagates to Java; elements still buffered when the consumer is destroyed are discarded, which fails
+     * an assertion in debug builds unless the native function exits with an exception.
+     *
+     * @tparam T The element type, passed to Java boxed if arithmetic.
+     * @tparam BatchSize The maximum number of elements delivered in a single native-to-Java transition.
+     */
+    template <typename T, std::size_t BatchSize = 1024>
+    class batched_consumer
+    {
+        static_assert(BatchSize > 0, "Batch size must be positive.");
+
+        using element_type = arg_type_t<boxed_t<T>>;
+
+    public:
+        batched_consumer(JNIEnv* env, jobject consumer)
+            : _consumer(env, consumer)
+        {
+            _items.reserve(BatchSize);
+        }
+
+        batched_consumer(batched_consumer&&) = default;
+        batched_consumer& operator=(batched_consumer&&) = default;
+
+        ~batched_consumer()
+        {
+            // delivering elements here would leave a Java exception pending while the native call converts its result
+            assert((_items.empty() || std::uncaught_exceptions() > 0) && "batched_consumer destroyed without flush");
+        }
+
+        void operator()(const T& value)
+        {
+            _items.push_back(value);
+            if (_items.size() >= BatchSize) {
+                flush();
+            }
+        }
+
+        void operator()(T&& value)
+        {
+            _items.push_back(std::move(value));
+            if (_items.size() >= BatchSize) {
+                flush();
+            }
+        }
+
+        /**
+         * Delivers all buffered elements to Java.
+         */
+        void flush()
+        {
+            if (_items.empty()) {
+                return;
+            }
+
+            JNIEnv* env = this_thread.getEnv();
+            if (env == nullptr) {
+                throw std::runtime_error("Cannot obtain Java environment for the current thread");
+            }
+            const ConsumerSupport& support = ConsumerSupport::get(env);
+
+            // elements are discarded even if delivery fails, such that a failed batch is not delivered again
+            std::vector<T> items;
+            items.swap(_items);
+            _items.reserve(BatchSize);
+
+            if (support.has_accept_all()) {
+                LocalObjectRef arr(env, env->NewObjectArray(static_cast<jsize>(items.size()), support.objectClass.ref(), nullptr));
+                if (arr.ref() == nullptr) {
+                    throw JavaException(env);
+                }
+                for (std::size_t k = 0; k < items.size(); ++k) {
+                    LocalObjectRef element(env, element_type::java_value(env, items[k]));
+                    env->SetObjectArrayElement(static_cast<jobjectArray>(arr.ref()), static_cast<jsize>(k), element.ref());
+                }
+                env->CallStaticVoidMethod(support.helperClass.ref(), support.acceptAllFunc.ref(), _consumer.ref(), arr.ref(), static_cast<jint>(items.size()));
+                if (env->ExceptionCheck()) {
+                    throw JavaException(env);
+                }
+            } else {
+                // helper class is not available, deliver elements one by one
+                for (auto&& item : items) {
+                    LocalObjectRef element(env, element_type::java_value(env, item));
+                    env->CallVoidMethod(_consumer.ref(), support.acceptFunc.ref(), element.ref());
+                    if (env->ExceptionCheck()) {
+                        throw JavaException(env);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Number of elements buffered but not yet delivered.
+         */
+        std::size_t pending() const
+        {
+            return _items.size();
+        }
+
+    private:
+        UniqueGlobalRef _consumer;
+        std::vector<T> _items;
+    };
+
+    template <typename T, std::size_t BatchSize>
+    struct JavaBatchedConsumerType
+    {
+        using native_type = batched_consumer<T, BatchSize>;
+        using java_type = jobject;
+
+        constexpr static std::string_view class_name = "java.util.function.Consumer";
+        constexpr static std::string_view java_name = GenericTraits<class_name, boxed_t<T>>::java_name;
+        constexpr static std::string_view sig = "Ljava/util/function/Consumer;";
+
+        static native_type native_value(JNIEnv* env, java_type obj)
+        {
+            if (obj == nullptr) {
+                throw JavaNullPointerException(env, "Consumer is null");
+            }
+            return native_type(env, obj);
+        }
+    };
+
+    template <typename T, std::size_t BatchSize> struct ArgType<batched_consumer<T, BatchSize>> { using type = JavaBatchedConsumerType<T, BatchSize>; };
+}
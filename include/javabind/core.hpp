@@ -475,6 +475,9 @@ namespace javabind
         constexpr static std::string_view class_path = replace_v<class_name, '.', '/'>;
         constexpr static std::string_view java_name = WrappedType::class_name;
 
+        /** Boxing holds a class reference besides the result. */
+        constexpr static jint local_capacity = 2;
+
     private:
         constexpr static std::string_view class_type_prefix = "L";
         constexpr static std::string_view class_type_suffix = ";";
@@ -545,6 +548,7 @@ namespace javabind
         using java_type = jstring;
 
         constexpr static std::string_view class_name = "java.lang.String";
+        constexpr static std::string_view class_path = "java/lang/String";
         constexpr static std::string_view java_name = "String";
         constexpr static std::string_view sig = "Ljava/lang/String;";
 
@@ -586,6 +590,7 @@ namespace javabind
         using java_type = jstring;
 
         constexpr static std::string_view class_name = "java.lang.String";
+        constexpr static std::string_view class_path = "java/lang/String";
         constexpr static std::string_view java_name = "String";
         constexpr static std::string_view sig = "Ljava/lang/String;";
 
@@ -609,6 +614,7 @@ namespace javabind
         using java_type = jstring;
 
         constexpr static std::string_view class_name = "java.lang.String";
+        constexpr static std::string_view class_path = "java/lang/String";
         constexpr static std::string_view java_name = "String";
         constexpr static std::string_view sig = "Ljava/lang/String;";
 
@@ -658,6 +664,7 @@ namespace javabind
         constexpr static std::string_view array_type_suffix = "]";
         constexpr static std::string_view java_name = join_v<arg_type_t<T>::java_name, array_type_prefix, array_type_suffix>;
         constexpr static std::string_view sig = join_v<array_type_prefix, arg_type_t<T>::sig>;
+        constexpr static std::string_view class_path = sig;
 
         static native_type native_value(JNIEnv* env, jarray arr)
         {
@@ -683,6 +690,7 @@ namespace javabind
 
         constexpr static std::string_view java_name = "boolean[]";
         constexpr static std::string_view sig = "[Z";
+        constexpr static std::string_view class_path = sig;
 
         static native_type native_value(JNIEnv* env, jarray arr)
         {
@@ -743,6 +751,7 @@ namespace javabind
         constexpr static std::string_view array_type_suffix = "]";
         constexpr static std::string_view java_name = join_v<arg_type_t<T>::java_name, array_type_prefix, array_type_suffix>;
         constexpr static std::string_view sig = join_v<array_type_prefix, arg_type_t<T>::sig>;
+        constexpr static std::string_view class_path = sig;
 
         static wrapped_array_view<T> native_value(JNIEnv* env, jarray arr)
         {
@@ -0,0 +1,258 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "executor.hpp"
+#include "function.hpp"
+#include "global.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace javabind
+{
+    /**
+     * A single native thread attached to the Java VM that runs callbacks raised on threads not attached to the Java VM.
+     *
+     * Producers push tasks to a lock-free queue, and the dispatcher thread takes all queued tasks at once, running them
+     * in order of submission. This bounds the number of threads attached to the Java VM to one, no matter how many
+     * internal threads a native library uses to raise callbacks.
+     */
+    class dispatcher
+    {
+    public:
+        /** Number of local references reserved for a batch of tasks. */
+        constexpr static jint batch_local_capacity = 16;
+
+        explicit dispatcher(std::string name = "javabind-dispatcher")
+        {
+            if (!this_thread.hasEnv()) {
+                throw std::runtime_error("Dispatcher requires the extension module to be loaded by the Java VM");
+            }
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            JNIAccounting::name(this, name);
+#endif
+            _thread = std::thread(&dispatcher::run, this, std::move(name));
+        }
+
+        dispatcher(const dispatcher&) = delete;
+        dispatcher& operator=(const dispatcher&) = delete;
+
+        /**
+         * Runs all pending tasks, and then terminates the dispatcher thread.
+         */
+        ~dispatcher()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+            _cv.notify_one();
+            _thread.join();
+        }
+
+        /**
+         * Schedules a task for execution on the dispatcher thread without waiting for its result.
+         */
+        template <typename Function>
+        void post(Function&& fn)
+        {
+            push(new Node{ unique_task(std::forward<Function>(fn)), nullptr });
+        }
+
+        /**
+         * Runs a task on the dispatcher thread, and waits for its result.
+         *
+         * Java exceptions raised by the task are re-thrown as a `std::runtime_error` that carries the exception
+         * message, since Java local references cannot cross thread boundaries.
+         */
+        template <typename Function>
+        auto call(Function&& fn) -> std::invoke_result_t<std::decay_t<Function>>
+        {
+            using result_type = std::invoke_result_t<std::decay_t<Function>>;
+
+            std::packaged_task<result_type()> task(
+                [fn = std::forward<Function>(fn)]() mutable -> result_type {
+                    try {
+                        return fn();
+                    } catch (JavaException& ex) {
+                        throw std::runtime_error(ex.what());
+                    }
+                }
+            );
+            std::future<result_type> future = task.get_future();
+            post(std::move(task));
+            return future.get();
+        }
+
+        /**
+         * A process-wide dispatcher, created on first use.
+         *
+         * The shared dispatcher is intentionally never destroyed, for the same reasons as `executor::shared()`.
+         */
+        static dispatcher& shared()
+        {
+            static dispatcher* instance = new dispatcher();
+            return *instance;
+        }
+
+    private:
+        struct Node
+        {
+            unique_task task;
+            Node* next;
+        };
+
+        void push(Node* node)
+        {
+            node->next = _head.load(std::memory_order_relaxed);
+            while (!_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+                // retry with updated head
+            }
+
+            // only a push to an empty queue may find the dispatcher thread waiting
+            if (node->next == nullptr) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cv.notify_one();
+            }
+        }
+
+        void run(std::string thread_name)
+        {
+            JNIEnv* env = this_thread.attach(thread_name.c_str());
+            JNIAccounting::binding_scope accounting(this);
+
+            while (true) {
+                Node* head;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _cv.wait(lock, [this]() { return _stopping || _head.load(std::memory_order_relaxed) != nullptr; });
+                    head = _head.exchange(nullptr, std::memory_order_acquire);
+                    if (head == nullptr) {
+                        return;  // stopping and no more tasks
+                    }
+                }
+
+                // tasks are taken in last-in first-out order, restore order of submission
+                Node* node = nullptr;
+                while (head != nullptr) {
+                    Node* next = head->next;
+                    head->next = node;
+                    node = head;
+                    head = next;
+                }
+
+                bool framed = env != nullptr && env->PushLocalFrame(batch_local_capacity) == JNI_OK;
+                if (env != nullptr && !framed) {
+                    env->ExceptionClear();
+                }
+                while (node != nullptr) {
+                    execute(node->task);
+                    if (env != nullptr && env->ExceptionCheck()) {
+                        env->ExceptionDescribe();
+                        env->ExceptionClear();
+                    }
+                    Node* next = node->next;
+                    delete node;
+                    node = next;
+                }
+                if (env != nullptr) {
+                    if (framed) {
+                        env->PopLocalFrame(nullptr);
+                    }
+                    ReleaseQueue::drain(env);
+                }
+            }
+        }
+
+        static void execute(unique_task& task) noexcept
+        {
+            try {
+                task();
+            } catch (...) {
+                // exceptions from posted tasks have no observer
+            }
+        }
+
+        std::atomic<Node*> _head = nullptr;
+        std::thread _thread;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _stopping = false;
+    };
+
+    namespace dispatch_policy
+    {
+        /** The calling thread waits until the callback has returned on the dispatcher thread. */
+        struct blocking {};
+
+        /** The calling thread continues without waiting; only callbacks without a result may be dispatched this way. */
+        struct fire_and_forget {};
+    }
+
+    /**
+     * A Java functional interface (e.g. `Function` or `Consumer`) whose invocations on threads not attached to the Java
+     * VM are forwarded to the shared dispatcher thread.
+     *
+     * Invocations on threads already attached to the Java VM (including the thread that received the function object)
+     * call Java directly.
+     *
+     * @tparam Sig A function signature such as `std::string(std::string)` that `std::function` would take.
+     * @tparam Policy Either `dispatch_policy::blocking` or `dispatch_policy::fire_and_forget`.
+     */
+    template <typename Sig, typename Policy = dispatch_policy::blocking>
+    struct dispatched;
+
+    template <typename R, typename Arg, typename Policy>
+    struct dispatched<R(Arg), Policy> : std::function<R(Arg)>
+    {
+        static_assert(
+            std::is_same_v<Policy, dispatch_policy::blocking> || (std::is_same_v<Policy, dispatch_policy::fire_and_forget> && std::is_void_v<R>),
+            "Only callbacks that return void can be dispatched without waiting for their result."
+        );
+
+        using std::function<R(Arg)>::function;
+    };
+
+    template <typename R, typename Arg, typename Policy>
+    struct JavaDispatchedFunctionType
+    {
+        using function_type = arg_type_t<std::function<R(Arg)>>;
+        using native_type = dispatched<R(Arg), Policy>;
+        using java_type = typename function_type::java_type;
+
+        constexpr static std::string_view class_name = function_type::class_name;
+        constexpr static std::string_view java_name = function_type::java_name;
+        constexpr static std::string_view sig = function_type::sig;
+
+        static native_type native_value(JNIEnv* env, java_type obj)
+        {
+            return native_type(
+                [fn = function_type::native_value(env, obj)](Arg arg) -> R
+                {
+                    if (this_thread.peekEnv() != nullptr) {
+                        return fn(arg);
+                    }
+                    if constexpr (std::is_same_v<Policy, dispatch_policy::fire_and_forget>) {
+                        dispatcher::shared().post([fn, arg = std::decay_t<Arg>(arg)]() { fn(arg); });
+                    } else {
+                        return dispatcher::shared().call([&fn, &arg]() -> R { return fn(arg); });
+                    }
+                }
+            );
+        }
+    };
+
+    template <typename R, typename Arg, typename Policy> struct ArgType<dispatched<R(Arg), Policy>> { using type = JavaDispatchedFunctionType<R, Arg, Policy>; };
+}
@@ -0,0 +1,305 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "global.hpp"
+#include "message.hpp"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace javabind
+{
+    /**
+     * A type-erased, move-only nullary function, such that tasks may own move-only resources (e.g. `UniqueGlobalRef`).
+     */
+    class unique_task
+    {
+    public:
+        unique_task() = default;
+
+        template <typename Function, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Function>, unique_task>>>
+        unique_task(Function&& fn)
+            : _impl(std::make_unique<Impl<std::decay_t<Function>>>(std::forward<Function>(fn)))
+        {}
+
+        void operator()()
+        {
+            _impl->invoke();
+        }
+
+    private:
+        struct Base
+        {
+            virtual ~Base() = default;
+            virtual void invoke() = 0;
+        };
+
+        template <typename Function>
+        struct Impl : Base
+        {
+            Impl(Function&& fn)
+                : fn(std::move(fn))
+            {}
+
+            Impl(const Function& fn)
+                : fn(fn)
+            {}
+
+            void invoke() override
+            {
+                fn();
+            }
+
+            Function fn;
+        };
+
+        std::unique_ptr<Base> _impl;
+    };
+
+    /**
+     * A pool of native worker threads attached to the Java VM.
+     *
+     * Each worker is attached once as a daemon thread named after the pool (e.g. `javabind-worker-1`), such that
+     * tasks may call Java functions (e.g. a `std::function` obtained from Java) without paying the cost of attaching
+     * and detaching the thread. Each task runs in its own local reference frame.
+     */
+    class executor
+    {
+    public:
+        /** Number of local references reserved for a task. */
+        constexpr static jint task_local_capacity = 16;
+
+        explicit executor(std::size_t thread_count = std::thread::hardware_concurrency(), std::string name = "javabind-worker")
+            : _name(std::move(name))
+        {
+            if (!this_thread.hasEnv()) {
+                throw std::runtime_error("Executor requires the extension module to be loaded by the Java VM");
+            }
+            if (thread_count == 0) {
+                thread_count = 1;
+            }
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            JNIAccounting::name(this, _name);
+#endif
+            _workers.reserve(thread_count);
+            for (std::size_t i = 0; i < thread_count; ++i) {
+                _workers.emplace_back(&executor::run, this, std::string(msg() << _name << "-" << (i + 1)));
+            }
+        }
+
+        executor(const executor&) = delete;
+        executor& operator=(const executor&) = delete;
+
+        /**
+         * Completes all pending tasks, and then terminates worker threads.
+         */
+        ~executor()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+            _cv.notify_all();
+            for (auto&& worker : _workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * Schedules a task for execution, and returns a future that receives its result.
+         *
+         * Java exceptions raised by the task are re-thrown by the future as a `std::runtime_error` that carries the
+         * exception message, since Java local references cannot cross thread boundaries.
+         */
+        template <typename Function>
+        auto submit(Function&& fn) -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+        {
+            using result_type = std::invoke_result_t<std::decay_t<Function>>;
+
+            std::packaged_task<result_type()> task(
+                [fn = std::forward<Function>(fn)]() mutable -> result_type {
+                    try {
+                        return fn();
+                    } catch (JavaException& ex) {
+                        throw std::runtime_error(ex.what());
+                    }
+                }
+            );
+            std::future<result_type> future = task.get_future();
+            enqueue(std::move(task), true);
+            return future;
+        }
+
+        /**
+         * Schedules a task for execution without waiting for its result.
+         *
+         * The task may be move-only. Exceptions escaping the task are discarded, and pending Java exceptions are
+         * printed and cleared, such that the worker thread remains usable.
+         */
+        template <typename Function>
+        void post(Function&& fn)
+        {
+            enqueue(unique_task(std::forward<Function>(fn)), true);
+        }
+
+        /**
+         * Schedules a task that makes no JNI calls, and returns a future that receives its result.
+         *
+         * The worker runs the task without a local reference frame and makes no JNI calls before or after the task,
+         * such that tasks may process data that another thread holds pinned in a critical region. The task runs in a
+         * scope in which `this_thread.getEnv()` must not be called. Tasks that make no JNI calls are queued separately
+         * and take precedence over other tasks, since a thread holding a critical region may be waiting for them.
+         */
+        template <typename Function>
+        auto submit_native(Function&& fn) -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+        {
+            using result_type = std::invoke_result_t<std::decay_t<Function>>;
+
+            std::packaged_task<result_type()> task(std::forward<Function>(fn));
+            std::future<result_type> future = task.get_future();
+            enqueue(std::move(task), false);
+            return future;
+        }
+
+        /**
+         * Schedules a task that makes no JNI calls without waiting for its result, as with `submit_native`.
+         */
+        template <typename Function>
+        void post_native(Function&& fn)
+        {
+            enqueue(unique_task(std::forward<Function>(fn)), false);
+        }
+
+        /**
+         * True if the current thread is a worker thread of any executor.
+         *
+         * A task that waits for other tasks of the same pool may deadlock if all workers are waiting; such code should
+         * run sequentially on worker threads.
+         */
+        static bool is_worker_thread()
+        {
+            return _is_worker;
+        }
+
+        /**
+         * Number of worker threads in the pool.
+         */
+        std::size_t size() const
+        {
+            return _workers.size();
+        }
+
+        /**
+         * A process-wide executor with a worker for each hardware thread, created on first use.
+         *
+         * The shared executor is intentionally never destroyed: its daemon threads do not block Java VM shutdown, and
+         * joining them from a static destructor could race with the Java VM tearing down.
+         */
+        static executor& shared()
+        {
+            static executor* instance = new executor();
+            return *instance;
+        }
+
+    private:
+        struct queued_task
+        {
+            unique_task task;
+            bool uses_jni;
+        };
+
+        void enqueue(unique_task&& task, bool uses_jni)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_stopping) {
+                    throw std::runtime_error(msg() << "Executor '" << _name << "' is shutting down");
+                }
+                (uses_jni ? _tasks : _native_tasks).push_back(queued_task{ std::move(task), uses_jni });
+            }
+            _cv.notify_one();
+        }
+
+        void run(std::string thread_name)
+        {
+            JNIEnv* env = this_thread.attach(thread_name.c_str());
+            JNIAccounting::binding_scope accounting(this);
+            _is_worker = true;
+
+            while (true) {
+                queued_task item;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _cv.wait(lock, [this]() { return _stopping || !_tasks.empty() || !_native_tasks.empty(); });
+
+                    // tasks that make no JNI calls first, a thread holding a critical region may be waiting for them
+                    std::deque<queued_task>& queue = !_native_tasks.empty() ? _native_tasks : _tasks;
+                    if (queue.empty()) {
+                        return;  // stopping and no more tasks
+                    }
+                    item = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                if (!item.uses_jni) {
+                    this_thread.setNoJNI(true);
+                    execute(item.task);
+                    this_thread.setNoJNI(false);
+                    continue;
+                }
+
+                // a frame releases local references created by the task; if no frame can be pushed, run without one
+                bool framed = env != nullptr && env->PushLocalFrame(task_local_capacity) == JNI_OK;
+                if (env != nullptr && !framed) {
+                    env->ExceptionClear();
+                }
+                execute(item.task);
+                if (env != nullptr) {
+                    if (env->ExceptionCheck()) {
+                        env->ExceptionDescribe();
+                        env->ExceptionClear();
+                    }
+                    if (framed) {
+                        env->PopLocalFrame(nullptr);
+                    }
+
+                    // release global references dropped by threads not attached to the Java VM
+                    ReleaseQueue::drain(env);
+                }
+            }
+        }
+
+        static void execute(unique_task& task) noexcept
+        {
+            try {
+                task();
+            } catch (...) {
+                // exceptions from posted tasks have no observer
+            }
+        }
+
+        inline static thread_local bool _is_worker = false;
+
+        std::string _name;
+        std::vector<std::thread> _workers;
+        std::deque<queued_task> _tasks;
+        std::deque<queued_task> _native_tasks;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _stopping = false;
+    };
+}
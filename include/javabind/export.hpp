@@ -92,6 +92,49 @@ namespace javabind
         os << "}\n";
     }
 
+    /**
+     * Generates the Java native signature of a function, and a forwarding method if the function is offloaded or
+     * traced.
+     */
+    static void write_native_method(std::ostream& os, std::string_view class_name, std::string_view modifiers, const javabind::FunctionBinding& binding)
+    {
+        if (!binding.has_wrapper()) {
+            os << detail::indent << "public " << modifiers << "native " << binding.return_display << " " << binding.name << "(" << binding.param_display << ");\n";
+            return;
+        }
+
+        bool returns_value = binding.return_display != "void";
+        std::string call = binding.native_name() + "(" + std::string(binding.param_names) + ")";
+        if (binding.offload) {
+            if (returns_value) {
+                call = "hu.info.hunyadi.javabind.NativeOffload.call(() -> " + call + ")";
+            } else {
+                call = "hu.info.hunyadi.javabind.NativeOffload.run(() -> " + call + ")";
+            }
+        }
+
+        os << detail::indent << "public " << modifiers << binding.return_display << " " << binding.name << "(" << binding.param_display << ") {\n";
+        if (binding.traced) {
+            // duration is measured unconditionally, fields are populated only if the event passes its settings
+            os << detail::indent << detail::indent << "hu.info.hunyadi.javabind.NativeCallEvent event = new hu.info.hunyadi.javabind.NativeCallEvent();\n";
+            os << detail::indent << detail::indent << "event.begin();\n";
+            os << detail::indent << detail::indent << "try {\n";
+            os << detail::indent << detail::indent << detail::indent << (returns_value ? "return " : "") << call << ";\n";
+            os << detail::indent << detail::indent << "} finally {\n";
+            os << detail::indent << detail::indent << detail::indent << "event.end();\n";
+            os << detail::indent << detail::indent << detail::indent << "if (event.shouldCommit()) {\n";
+            os << detail::indent << detail::indent << detail::indent << detail::indent << "event.binding = " << class_name << ".class.getName() + \"." << binding.name << "\";\n";
+            os << detail::indent << detail::indent << detail::indent << detail::indent << "event.argumentSize = hu.info.hunyadi.javabind.NativeCallEvent.sizeOf(" << binding.param_names << ");\n";
+            os << detail::indent << detail::indent << detail::indent << detail::indent << "event.commit();\n";
+            os << detail::indent << detail::indent << detail::indent << "}\n";
+            os << detail::indent << detail::indent << "}\n";
+        } else {
+            os << detail::indent << detail::indent << (returns_value ? "return " : "") << call << ";\n";
+        }
+        os << detail::indent << "}\n";
+        os << detail::indent << "private " << modifiers << "native " << binding.return_display << " " << binding.native_name() << "(" << binding.param_display << ");\n";
+    }
+
     /** Generates Java native signatures for regular class types. */
     static void write_native_class(std::ostream& os, std::string_view class_name, const std::vector<javabind::FunctionBinding>& bindings)
     {
@@ -110,12 +153,12 @@ namespace javabind
 
         for (auto&& binding : bindings) {
             if (!binding.is_member) {
-                os << detail::indent << "public static native " << binding.return_display << " " << binding.name << "(" << binding.param_display << ");\n";
+                write_native_method(os, class_name, "static ", binding);
             }
         }
         for (auto&& binding : bindings) {
             if (binding.is_member) {
-                os << detail::indent << "public native " << binding.return_display << " " << binding.name << "(" << binding.param_display << ");\n";
+                write_native_method(os, class_name, "", binding);
             }
         }
         os << "}\n";
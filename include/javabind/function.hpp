@@ -12,6 +12,7 @@
 #include "local.hpp"
 #include "global.hpp"
 #include "signature.hpp"
+#include "traits.hpp"
 #include <functional>
 
 namespace javabind
@@ -20,8 +21,11 @@ namespace javabind
     {
         virtual ~BaseCallback() {}
 
-        static void deallocate(JNIEnv*, jlong ptr)
+        static void deallocate(JNIEnv* env, jclass, jlong ptr)
         {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(deallocate));
             delete reinterpret_cast<BaseCallback*>(ptr);
         }
     };
@@ -40,7 +44,7 @@ namespace javabind
     >
     {
         ForwardingCallback(std::function<R(T)>&& func)
-            : _func(func)
+            : _func(std::move(func))
         {}
 
         using java_arg_type = typename arg_type_t<T>::java_type;
@@ -462,4 +466,113 @@ namespace javabind
     template <> struct ArgType<std::function<void(int32_t)>> { using type = JavaIntConsumerType; };
     template <> struct ArgType<std::function<void(int64_t)>> { using type = JavaLongConsumerType; };
     template <> struct ArgType<std::function<void(double)>> { using type = JavaDoubleConsumerType; };
+
+    /**
+     * A non-owning view of a Java functional interface (e.g. `Function` or `Predicate`), valid only for the duration
+     * of the native call that received it, and only on the thread of that call.
+     *
+     * Unlike a Java function object received as `std::function`, a view holds no global reference, and binds the JNI
+     * environment and the method identifier of the enclosing native call. Calling the view involves no type erasure
+     * and no thread-local storage lookup, which suits a Java function called in a tight loop, e.g. as a comparator.
+     *
+     * @tparam Sig A function signature such as `bool(std::string)` that `std::function` would take.
+     */
+    template <typename Sig>
+    class function_view;
+
+    template <typename R, typename Arg>
+    class function_view<R(Arg)>
+    {
+        using wrapper_type = arg_type_t<std::function<R(Arg)>>;
+        using java_arg_type = typename arg_type_t<std::decay_t<Arg>>::java_type;
+        using java_result_type = typename arg_type_t<R>::java_type;
+
+    public:
+        function_view(JNIEnv* env, jobject fn)
+            : _env(env)
+            , _fn(fn)
+        {
+            LocalClassRef cls(env, fn);
+            _invoke = cls.getMethod(wrapper_type::apply_fn, wrapper_type::apply_sig);
+        }
+
+        R operator()(const std::decay_t<Arg>& arg) const
+        {
+            if constexpr (std::is_pointer_v<java_arg_type>) {
+                LocalObjectRef javaArg(_env, arg_type_t<std::decay_t<Arg>>::java_value(_env, arg));
+                return invoke(static_cast<java_arg_type>(javaArg.ref()));
+            } else {
+                return invoke(arg_type_t<std::decay_t<Arg>>::java_value(_env, arg));
+            }
+        }
+
+    private:
+        R invoke(java_arg_type javaArg) const
+        {
+            jmethodID m = _invoke.ref();
+            if constexpr (std::is_void_v<R>) {
+                _env->CallVoidMethod(_fn, m, javaArg);
+                if (_env->ExceptionCheck()) {
+                    throw JavaException(_env);
+                }
+            } else if constexpr (std::is_pointer_v<java_result_type>) {
+                LocalObjectRef res(_env, _env->CallObjectMethod(_fn, m, javaArg));
+                if (_env->ExceptionCheck()) {
+                    throw JavaException(_env);
+                }
+                return arg_type_t<R>::native_value(_env, static_cast<java_result_type>(res.ref()));
+            } else {
+                java_result_type res = call_primitive(m, javaArg);
+                if (_env->ExceptionCheck()) {
+                    throw JavaException(_env);
+                }
+                return arg_type_t<R>::native_value(_env, res);
+            }
+        }
+
+        java_result_type call_primitive(jmethodID m, java_arg_type javaArg) const
+        {
+            if constexpr (std::is_same_v<java_result_type, jboolean>) {
+                return _env->CallBooleanMethod(_fn, m, javaArg);
+            } else if constexpr (std::is_same_v<java_result_type, jint>) {
+                return _env->CallIntMethod(_fn, m, javaArg);
+            } else if constexpr (std::is_same_v<java_result_type, jlong>) {
+                return _env->CallLongMethod(_fn, m, javaArg);
+            } else {
+                static_assert(std::is_same_v<java_result_type, jdouble>, "Unsupported result type for a Java functional interface.");
+                return _env->CallDoubleMethod(_fn, m, javaArg);
+            }
+        }
+
+        JNIEnv* _env;
+        jobject _fn;
+        Method _invoke;
+    };
+
+    template <typename Sig>
+    struct JavaFunctionViewType;
+
+    template <typename R, typename Arg>
+    struct JavaFunctionViewType<R(Arg)>
+    {
+        using function_type = arg_type_t<std::function<R(Arg)>>;
+        using native_type = function_view<R(Arg)>;
+        using java_type = jobject;
+
+        constexpr static std::string_view class_name = function_type::class_name;
+        constexpr static std::string_view java_name = function_type::java_name;
+        constexpr static std::string_view sig = function_type::sig;
+
+        static native_type native_value(JNIEnv* env, java_type obj)
+        {
+            if (obj == nullptr) {
+                throw JavaNullPointerException(env, "Function is null");
+            }
+            return native_type(env, obj);
+        }
+    };
+
+    template <typename Sig> struct ArgType<function_view<Sig>> { using type = JavaFunctionViewType<Sig>; };
+
+    template <typename Sig> struct is_call_scoped<function_view<Sig>> : std::true_type {};
 }
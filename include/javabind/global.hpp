@@ -9,8 +9,11 @@
  */
 
 #pragma once
+#include "accounting.hpp"
 #include "local.hpp"
-#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <utility>
 
 namespace javabind
 {
@@ -49,6 +52,7 @@ namespace javabind
         JNIEnv* getEnv()
         {
             assert(_vm != nullptr);
+            assert(!_no_jni && "JNI must not be called while a critical region is held");
 
             if (_env == nullptr) {
                 // attach thread to obtain an environment
@@ -71,7 +75,60 @@ namespace javabind
                 }
             }
 
-            return _env;
+            return accounted(_env);
+        }
+
+        /**
+         * Returns the environment of the current thread if the thread is attached to the Java VM, without attaching it.
+         */
+        JNIEnv* peekEnv()
+        {
+            if (_no_jni) {
+                return nullptr;  // defer work that would call JNI
+            }
+            if (_env == nullptr && _vm != nullptr) {
+                if (_vm->GetEnv(reinterpret_cast<void**>(&_env), JNI_VERSION_1_6) != JNI_OK) {
+                    _env = nullptr;
+                }
+            }
+            return accounted(_env);
+        }
+
+        /**
+         * Attaches the current thread to the Java VM as a daemon thread with the given name.
+         *
+         * Meant for long-lived native threads that call into Java repeatedly. A daemon thread does not prevent the
+         * Java VM from shutting down. The thread is detached when it terminates.
+         */
+        JNIEnv* attach(const char* name)
+        {
+            assert(_vm != nullptr);
+
+            if (_env != nullptr) {
+                return accounted(_env);  // already attached
+            }
+
+            JavaVMAttachArgs args = { JNI_VERSION_1_6, const_cast<char*>(name), nullptr };
+            if (_vm->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&_env), &args) != JNI_OK) {
+                _env = nullptr;
+                return nullptr;
+            }
+            _attached = true;
+            return accounted(_env);
+        }
+
+        /**
+         * Marks the beginning or end of a code region in which the current thread must not call JNI functions, e.g.
+         * a native kernel running on data in a Java array pinned with `GetPrimitiveArrayCritical`.
+         */
+        void setNoJNI(bool no_jni)
+        {
+            _no_jni = no_jni;
+        }
+
+        bool isNoJNI() const
+        {
+            return _no_jni;
         }
 
         ~Environment()
@@ -91,6 +148,7 @@ namespace javabind
         inline static JavaVM* _vm = nullptr;
         JNIEnv* _env = nullptr;
         bool _attached = false;
+        bool _no_jni = false;
     };
 
     /**
@@ -99,32 +157,285 @@ namespace javabind
     static thread_local Environment this_thread;
 
     /**
-     * An adapter for an object reference handle that remains valid as the native-to-Java boundary is crossed.
+     * A lock-free multiple-producer single-consumer queue of global references whose release has been deferred.
+     *
+     * A thread that is not attached to the Java VM cannot delete a global reference without attaching first, which is
+     * costly and keeps the thread attached until it terminates. Instead, such threads push the reference to this
+     * queue, and the queue is drained in a single batch on the next call from Java into native code, or by a worker
+     * thread of the native executor.
      */
-    class GlobalObjectRef
+    class ReleaseQueue
     {
     public:
-        using jobject_struct = std::pointer_traits<jobject>::element_type;
+        static void push(jobject ref)
+        {
+            Node* node = new Node{ ref, _head.load(std::memory_order_relaxed) };
+            while (!_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+                // retry with updated head
+            }
+            _pending.fetch_add(1, std::memory_order_relaxed);
+        }
 
-        GlobalObjectRef(JNIEnv* env, jobject obj)
+        /**
+         * The number of global references waiting to be released.
+         */
+        static std::size_t pending()
         {
-            _ref = std::shared_ptr<jobject_struct>(
-                env->NewGlobalRef(obj),
-                [](jobject ref) {
-                    JNIEnv* env = this_thread.getEnv();
-                    if (env != nullptr) {
-                        env->DeleteGlobalRef(ref);
-                    }
-                }
-            );
+            return _pending.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Releases all global references in the queue. Must be called on a thread attached to the Java VM.
+         */
+        static void drain(JNIEnv* env)
+        {
+            if (_head.load(std::memory_order_relaxed) == nullptr) {
+                return;  // fast path, nothing to release
+            }
+
+            // take ownership of the entire list; producers continue pushing to an empty list
+            Node* node = _head.exchange(nullptr, std::memory_order_acquire);
+            std::size_t count = 0;
+            while (node != nullptr) {
+                env->DeleteGlobalRef(node->ref);
+                Node* next = node->next;
+                delete node;
+                node = next;
+                ++count;
+            }
+            _pending.fetch_sub(count, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Node
+        {
+            jobject ref;
+            Node* next;
+        };
+
+        inline static std::atomic<Node*> _head = nullptr;
+        inline static std::atomic<std::size_t> _pending = 0;
+    };
+
+    /**
+     * Deletes a global reference, or defers its release if the current thread is not attached to the Java VM.
+     */
+    inline void release_global_ref(jobject ref)
+    {
+        if (ref == nullptr) {
+            return;
+        }
+        JNIEnv* env = this_thread.peekEnv();
+        if (env != nullptr) {
+            env->DeleteGlobalRef(ref);
+        } else {
+            ReleaseQueue::push(ref);
+        }
+    }
+
+    /**
+     * A move-only owner of a global reference, for references whose ownership is passed along linearly, e.g. from
+     * the Java thread that creates the reference to the native thread that consumes it.
+     *
+     * Unlike a shared global reference, it involves no heap allocation and no reference counting.
+     */
+    class UniqueGlobalRef
+    {
+    public:
+        UniqueGlobalRef() = default;
+
+        UniqueGlobalRef(JNIEnv* env, jobject obj)
+            : _ref(obj != nullptr ? env->NewGlobalRef(obj) : nullptr)
+        {}
+
+        UniqueGlobalRef(const UniqueGlobalRef&) = delete;
+        UniqueGlobalRef& operator=(const UniqueGlobalRef&) = delete;
+
+        UniqueGlobalRef(UniqueGlobalRef&& op) noexcept
+            : _ref(op._ref)
+        {
+            op._ref = nullptr;
+        }
+
+        UniqueGlobalRef& operator=(UniqueGlobalRef&& op) noexcept
+        {
+            if (this != &op) {
+                release_global_ref(_ref);
+                _ref = op._ref;
+                op._ref = nullptr;
+            }
+            return *this;
+        }
+
+        ~UniqueGlobalRef()
+        {
+            release_global_ref(_ref);
         }
 
         jobject ref() const
         {
-            return _ref.get();
+            return _ref;
+        }
+
+    private:
+        jobject _ref = nullptr;
+    };
+
+    /**
+     * Reference counting policy for handles that may be copied and destroyed on several threads concurrently.
+     */
+    struct atomic_ref_count
+    {
+        using counter_type = std::atomic<std::size_t>;
+
+        static void increment(counter_type& count)
+        {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /** Returns true if the last reference has been dropped. */
+        static bool decrement(counter_type& count)
+        {
+            return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+    };
+
+    /**
+     * Reference counting policy for handles whose copies never leave the thread that created them.
+     */
+    struct local_ref_count
+    {
+        using counter_type = std::size_t;
+
+        static void increment(counter_type& count)
+        {
+            ++count;
+        }
+
+        /** Returns true if the last reference has been dropped. */
+        static bool decrement(counter_type& count)
+        {
+            return --count == 0;
+        }
+    };
+
+    /**
+     * A copyable owner of a global reference with an intrusive reference count.
+     *
+     * The global reference and its reference count share a single allocation. With the policy `local_ref_count`,
+     * copies avoid atomic operations altogether, which suits handles confined to a single thread.
+     *
+     * @tparam Policy Either `atomic_ref_count` or `local_ref_count`.
+     */
+    template <typename Policy>
+    class SharedGlobalRef
+    {
+    public:
+        SharedGlobalRef() = default;
+
+        SharedGlobalRef(JNIEnv* env, jobject obj)
+        {
+            if (obj != nullptr) {
+                _block = new Block{ env->NewGlobalRef(obj), 1 };
+            }
+        }
+
+        SharedGlobalRef(const SharedGlobalRef& op) noexcept
+            : _block(op._block)
+        {
+            if (_block != nullptr) {
+                Policy::increment(_block->count);
+            }
+        }
+
+        SharedGlobalRef(SharedGlobalRef&& op) noexcept
+            : _block(op._block)
+        {
+            op._block = nullptr;
+        }
+
+        SharedGlobalRef& operator=(SharedGlobalRef op) noexcept
+        {
+            std::swap(_block, op._block);
+            return *this;
+        }
+
+        ~SharedGlobalRef()
+        {
+            if (_block != nullptr && Policy::decrement(_block->count)) {
+                release_global_ref(_block->ref);
+                delete _block;
+            }
+        }
+
+        jobject ref() const
+        {
+            return _block != nullptr ? _block->ref : nullptr;
+        }
+
+        /** The number of handles that share the global reference, or zero for an empty handle. */
+        std::size_t use_count() const
+        {
+            return _block != nullptr ? static_cast<std::size_t>(_block->count) : 0;
+        }
+
+    private:
+        struct Block
+        {
+            jobject ref;
+            typename Policy::counter_type count;
+        };
+
+        Block* _block = nullptr;
+    };
+
+    /**
+     * An adapter for an object reference handle that remains valid as the native-to-Java boundary is crossed.
+     *
+     * Copies may be shared across threads. If the last copy is destroyed on a thread not attached to the Java VM,
+     * the release of the global reference is deferred to the next call from Java, see `ReleaseQueue`.
+     */
+    using GlobalObjectRef = SharedGlobalRef<atomic_ref_count>;
+
+    /**
+     * An adapter for a class reference handle that remains valid across threads and native-to-Java transitions.
+     *
+     * Meant to cache classes and member identifiers in static variables. The global reference is intentionally
+     * never released: a class cannot be unloaded while the extension module that references it is loaded.
+     */
+    class GlobalClassRef
+    {
+    public:
+        GlobalClassRef() = default;
+
+        GlobalClassRef(JNIEnv* env, const LocalClassRef& cls)
+        {
+            if (cls.ref() != nullptr) {
+                _ref = static_cast<jclass>(env->NewGlobalRef(cls.ref()));
+            }
+        }
+
+        Method getMethod(JNIEnv* env, const char* name, const std::string_view& signature) const
+        {
+            return Method(env, _ref, name, signature);
+        }
+
+        StaticMethod getStaticMethod(JNIEnv* env, const char* name, const std::string_view& signature) const
+        {
+            return StaticMethod(env, _ref, name, signature);
+        }
+
+        Field getField(JNIEnv* env, const std::string_view& name, const std::string_view& signature) const
+        {
+            return Field(env, _ref, name, signature);
+        }
+
+        jclass ref() const
+        {
+            return _ref;
         }
 
     private:
-        std::shared_ptr<jobject_struct> _ref;
+        jclass _ref = nullptr;
     };
 }
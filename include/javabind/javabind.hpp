@@ -17,8 +17,10 @@
 #include "output.hpp"
 #include "binding.hpp"
 #include "callback.hpp"
+#include "executor.hpp"
 #include "message.hpp"
 #include "export.hpp"
+#include "startup.hpp"
 #include <algorithm>
 
 namespace javabind
@@ -69,12 +71,18 @@ static jint java_initialization_impl(JavaVM* vm, void (*initializer)())
     // register Java environment
     Environment::load(vm);
     this_thread.setEnv(env);
+    env = accounted(env);
 
+    StartupProfiler profiler;
     try {
         // invoke user-defined function
+        profiler.start();
         initializer();
+        profiler.stop(StartupPhase::initializer);
 
         // register callback bindings
+        profiler.start();
+
         rc = CallbackRegistry(env)
             .add<bool, object>()
             .add<bool, int32_t>()
@@ -95,10 +103,21 @@ static jint java_initialization_impl(JavaVM* vm, void (*initializer)())
             .add<void, int32_t>()
             .add<void, int64_t>()
             .add<void, double>()
+            .add_stream()
             .code();
+        if (rc != JNI_OK) {
+            return rc;
+        }
+
+        // look up bundled helper classes while the class loader of the extension module is in context
+        CollectionSupport::get(env);
+        ConsumerSupport::get(env);
+        profiler.stop(StartupPhase::callback_registry);
 
         // register function bindings
         for (auto&& [class_name, bindings] : FunctionBindings::value) {
+            profiler.start();
+
             // find the native class; JNI_OnLoad is called from the correct class loader context for this to work
             std::string cn(class_name.data(), class_name.size());
             std::replace(cn.begin(), cn.end(), '.', '/');
@@ -111,20 +130,50 @@ static jint java_initialization_impl(JavaVM* vm, void (*initializer)())
             }
 
             // register native methods of the class
+            std::vector<std::string> names;
+            names.reserve(bindings.size());  // pointers to names must remain valid
             std::vector<JNINativeMethod> functions;
             for (auto it = bindings.begin(); it != bindings.end(); ++it) {
+                names.push_back(it->native_name());
                 JNINativeMethod m = {
-                    const_cast<char*>(it->name.data()),
+                    const_cast<char*>(names.back().c_str()),
                     const_cast<char*>(it->signature.data()),
                     it->function_entry_point
                 };
                 functions.push_back(m);
+                StatisticsRegistry::add(msg() << class_name << "." << it->name, it->statistics);
+#if defined(JAVABIND_JNI_ACCOUNTING)
+                JNIAccounting::name(it->function_entry_point, msg() << class_name << "." << it->name);
+#endif
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+                LocalRefTracker::name(it->function_entry_point, msg() << class_name << "." << it->name);
+#endif
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+                PayloadProfiler::name(it->function_entry_point, msg() << class_name << "." << it->name);
+#endif
             }
             rc = env->RegisterNatives(cls.ref(), functions.data(), static_cast<jint>(functions.size()));
             if (rc != JNI_OK) {
                 return rc;
             }
+            profiler.stop(StartupPhase::function_registration, class_name);
+        }
+
+        // expose call statistics to Java
+        profiler.start();
+        rc = StatisticsHandler::register_natives(env);
+        if (rc != JNI_OK) {
+            return rc;
+        }
+        profiler.stop(StartupPhase::function_registration, "hu.info.hunyadi.javabind.NativeStats");
+
+        // expose native object counts to Java
+        profiler.start();
+        rc = NativeObjectHandler::register_natives(env);
+        if (rc != JNI_OK) {
+            return rc;
         }
+        profiler.stop(StartupPhase::function_registration, "hu.info.hunyadi.javabind.NativeObject");
 
         if (env->ExceptionCheck()) {
             return JNI_ERR;
@@ -132,6 +181,8 @@ static jint java_initialization_impl(JavaVM* vm, void (*initializer)())
 
         // check property bindings
         for (auto&& [class_name, bindings] : FieldBindings::value) {
+            profiler.start();
+
             // find the native class; JNI_OnLoad is called from the correct class loader context for this to work
             LocalClassRef cls(env, class_name, std::nothrow);
             if (cls.ref() == nullptr) {
@@ -153,10 +204,13 @@ static jint java_initialization_impl(JavaVM* vm, void (*initializer)())
                 );
                 return JNI_ERR;
             }
+            profiler.stop(StartupPhase::record_validation, class_name);
         }
 
         // initialize enum bindings
         for (auto&& [class_name, bindings] : EnumBindings::value) {
+            profiler.start();
+
             // find the enum class; JNI_OnLoad is called from the correct class loader context for this to work
             std::string cn(class_name.data(), class_name.size());
             std::replace(cn.begin(), cn.end(), '.', '/');
@@ -226,6 +280,16 @@ static jint java_initialization_impl(JavaVM* vm, void (*initializer)())
             }
 
             bindings.initialize(values);
+            profiler.stop(StartupPhase::enum_initialization, class_name);
+        }
+
+        // report time spent in initialization
+        if (startup_options::print_profile) {
+            JavaOutput output(env);
+            profiler.profile().print(output.stream());
+        }
+        if (startup_options::profile_handler) {
+            startup_options::profile_handler(profiler.profile());
         }
     } catch (const std::exception& ex) {
         // ensure no native exception is propagated to Java
@@ -13,6 +13,7 @@
 #include <cassert>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 namespace javabind
 {
@@ -92,6 +93,7 @@ namespace javabind
     };
 
     class LocalClassRef;
+    class GlobalClassRef;
 
     /**
      * C++ wrapper class of [jmethodID] for instance methods.
@@ -111,6 +113,7 @@ namespace javabind
         }
 
         friend LocalClassRef;
+        friend GlobalClassRef;
 
         jmethodID _ref = nullptr;
 
@@ -143,6 +146,7 @@ namespace javabind
         StaticMethod(const StaticMethod&) = delete;
 
         friend LocalClassRef;
+        friend GlobalClassRef;
 
         jmethodID _ref = nullptr;
 
@@ -175,6 +179,7 @@ namespace javabind
         Field(const Field&) = delete;
 
         friend LocalClassRef;
+        friend GlobalClassRef;
 
         jfieldID _ref = nullptr;
 
@@ -207,6 +212,7 @@ namespace javabind
         StaticField(const StaticField&) = delete;
 
         friend LocalClassRef;
+        friend GlobalClassRef;
 
         jfieldID _ref = nullptr;
 
@@ -257,6 +263,82 @@ namespace javabind
         jobject _ref = nullptr;
     };
 
+    /**
+     * Scoped C++ wrapper of a JNI local reference frame.
+     *
+     * All local references created while the frame is active are released when the frame is popped, and the
+     * capacity requested up front prevents the Java VM from growing its local reference table during a conversion.
+     * Local references created in the frame must not be used (or deleted) after the frame has been popped.
+     */
+    class LocalFrame
+    {
+    public:
+        LocalFrame(JNIEnv* env, jint capacity)
+            : _env(env)
+        {
+            if (env->PushLocalFrame(capacity) != JNI_OK) {
+                _env = nullptr;
+                throw JavaException(env);  // out of memory
+            }
+        }
+
+        LocalFrame(const LocalFrame&) = delete;
+        LocalFrame& operator=(const LocalFrame&) = delete;
+
+        ~LocalFrame()
+        {
+            if (_env != nullptr) {
+                _env->PopLocalFrame(nullptr);
+            }
+        }
+
+        /**
+         * Pops the frame, and returns a local reference to the result that is valid in the enclosing frame.
+         */
+        jobject pop(jobject result)
+        {
+            JNIEnv* env = _env;
+            _env = nullptr;
+            return env->PopLocalFrame(result);
+        }
+
+        /**
+         * Pops the frame, and re-throws a Java exception that has been raised in the frame.
+         * The exception object is moved to the enclosing frame such that it remains valid.
+         */
+        [[noreturn]] void rethrow(const JavaException& ex)
+        {
+            jthrowable outer = static_cast<jthrowable>(pop(ex.innerException()));
+            throw JavaException(outer, ex.what());
+        }
+
+    private:
+        JNIEnv* _env;
+    };
+
+    /**
+     * Invokes a function in a new local reference frame with the given capacity.
+     *
+     * If the function returns a local reference, the reference is moved to the enclosing frame. Any local
+     * references the function creates must be released (e.g. by going out of scope) before the function returns.
+     */
+    template <typename Function>
+    auto with_local_frame(JNIEnv* env, jint capacity, Function&& fn) -> std::invoke_result_t<Function>
+    {
+        using result_type = std::invoke_result_t<Function>;
+
+        LocalFrame frame(env, capacity);
+        try {
+            if constexpr (std::is_convertible_v<result_type, jobject>) {
+                return static_cast<result_type>(frame.pop(fn()));
+            } else {
+                return fn();
+            }
+        } catch (JavaException& ex) {
+            frame.rethrow(ex);
+        }
+    }
+
     /**
      * Scoped C++ wrapper class of [jclass].
      */
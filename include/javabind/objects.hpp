@@ -0,0 +1,161 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "local.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace javabind
+{
+    /**
+     * Number of native objects of a class instantiated and disposed of from Java.
+     */
+    struct NativeObjectCounts
+    {
+        std::string_view class_name;
+        std::uint64_t created = 0;
+        std::uint64_t destroyed = 0;
+        /** Size of a single native object, not including memory that the object allocates. */
+        std::size_t object_size = 0;
+
+        /** Number of native objects whose Java object has not been closed. */
+        std::uint64_t live() const
+        {
+            return created > destroyed ? created - destroyed : 0;
+        }
+
+        /** Estimated memory held by live native objects, based on `sizeof`. */
+        std::uint64_t live_bytes() const
+        {
+            return live() * object_size;
+        }
+    };
+
+    /**
+     * Counts native objects of a class, updated by the object construction and destruction adapters.
+     */
+    template <typename T>
+    struct NativeObjectCounters
+    {
+        inline static std::atomic<std::uint64_t> created = 0;
+        inline static std::atomic<std::uint64_t> destroyed = 0;
+
+        static NativeObjectCounts get(std::string_view class_name)
+        {
+            NativeObjectCounts counts;
+            counts.class_name = class_name;
+            counts.destroyed = destroyed.load(std::memory_order_relaxed);
+            counts.created = created.load(std::memory_order_relaxed);
+            counts.object_size = sizeof(T);
+            return counts;
+        }
+    };
+
+    /**
+     * Classes registered with `native_class`, mapped to a function that returns the object counts of the class.
+     */
+    struct NativeObjectRegistry
+    {
+        using key_type = std::string_view;
+        using value_type = NativeObjectCounts(*)();
+
+        inline static std::map<key_type, value_type> value;
+    };
+
+    /**
+     * Returns the number of native objects of a class registered with `native_class`.
+     */
+    inline NativeObjectCounts native_object_counts(std::string_view class_name)
+    {
+        auto it = NativeObjectRegistry::value.find(class_name);
+        if (it == NativeObjectRegistry::value.end()) {
+            NativeObjectCounts counts;
+            counts.class_name = class_name;
+            return counts;
+        }
+        return it->second();
+    }
+
+    /**
+     * Returns the number of native objects of each class registered with `native_class`.
+     */
+    inline std::vector<NativeObjectCounts> native_object_counts()
+    {
+        std::vector<NativeObjectCounts> result;
+        result.reserve(NativeObjectRegistry::value.size());
+        for (auto&& [class_name, get] : NativeObjectRegistry::value) {
+            result.push_back(get());
+        }
+        return result;
+    }
+
+    /**
+     * Implements the static native methods of the bundled Java class `NativeObject` that query object counts.
+     */
+    struct NativeObjectHandler
+    {
+        static jlongArray objectCounts(JNIEnv* env, jclass, jstring class_name)
+        {
+            jlong values[4] = {};
+            if (class_name != nullptr) {
+                const char* chars = env->GetStringUTFChars(class_name, nullptr);
+                NativeObjectCounts counts = native_object_counts(chars);
+                env->ReleaseStringUTFChars(class_name, chars);
+                values[0] = static_cast<jlong>(counts.created);
+                values[1] = static_cast<jlong>(counts.destroyed);
+                values[2] = static_cast<jlong>(counts.live());
+                values[3] = static_cast<jlong>(counts.live_bytes());
+            }
+            jlongArray arr = env->NewLongArray(4);
+            if (arr != nullptr) {
+                env->SetLongArrayRegion(arr, 0, 4, values);
+            }
+            return arr;
+        }
+
+        static jstring objectReport(JNIEnv* env, jclass)
+        {
+            std::ostringstream os;
+            for (auto&& counts : native_object_counts()) {
+                os << counts.class_name << ": live=" << counts.live() << " created=" << counts.created
+                    << " destroyed=" << counts.destroyed << " bytes=" << counts.live_bytes() << "\n";
+            }
+            return env->NewStringUTF(os.str().c_str());
+        }
+
+        /**
+         * Registers the native methods of `NativeObject`, unless an earlier version of the class without object
+         * counts is visible to the class loader.
+         */
+        static jint register_natives(JNIEnv* env)
+        {
+            LocalClassRef cls(env, "hu/info/hunyadi/javabind/NativeObject", std::nothrow);
+            if (cls.ref() == nullptr) {
+                env->ExceptionClear();
+                return JNI_OK;
+            }
+            JNINativeMethod methods[] = {
+                { const_cast<char*>("objectCounts"), const_cast<char*>("(Ljava/lang/String;)[J"), reinterpret_cast<void*>(objectCounts) },
+                { const_cast<char*>("objectReport"), const_cast<char*>("()Ljava/lang/String;"), reinterpret_cast<void*>(objectReport) }
+            };
+            if (env->RegisterNatives(cls.ref(), methods, static_cast<jint>(std::size(methods))) != JNI_OK) {
+                env->ExceptionClear();
+            }
+            return JNI_OK;
+        }
+    };
+}
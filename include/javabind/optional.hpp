@@ -30,6 +30,8 @@ namespace javabind
         using native_type = std::optional<T>;
         using java_type = jobject;
 
+        constexpr static jint local_capacity = local_capacity_v<boxed_t<T>>;
+
         static native_type native_value(JNIEnv* env, java_type javaOptional)
         {
             if (javaOptional == nullptr)
@@ -0,0 +1,239 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "core.hpp"
+#include "executor.hpp"
+#include "global.hpp"
+#include "message.hpp"
+#include "traits.hpp"
+#include "view.hpp"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace javabind
+{
+    /**
+     * Marks a scope in which the current thread must not call JNI functions.
+     *
+     * In debug builds, obtaining the JNI environment with `this_thread.getEnv()` in this scope fails an assertion.
+     * Global references released in this scope are queued, and deleted later on a thread that may call JNI.
+     */
+    class no_jni_scope
+    {
+    public:
+        no_jni_scope()
+            : _outer(this_thread.isNoJNI())
+        {
+            this_thread.setNoJNI(true);
+        }
+
+        no_jni_scope(const no_jni_scope&) = delete;
+        no_jni_scope& operator=(const no_jni_scope&) = delete;
+
+        ~no_jni_scope()
+        {
+            this_thread.setNoJNI(_outer);
+        }
+
+    private:
+        bool _outer;
+    };
+
+    /**
+     * A Java primitive array passed to a native function that is not pinned until its data is needed.
+     *
+     * Unlike `std::basic_string_view<T>`, which keeps the array pinned until the native function returns, the array
+     * is pinned only for the duration of `parallel_for_view`.
+     */
+    template <typename T>
+    class pinned_array
+    {
+        static_assert(std::is_arithmetic_v<T>, "Only arrays of primitive types can be pinned.");
+
+    public:
+        pinned_array(JNIEnv* env, jarray arr)
+            : _env(env)
+            , _arr(arr)
+        {}
+
+        std::size_t size() const
+        {
+            return _env->GetArrayLength(_arr);
+        }
+
+        JNIEnv* env() const
+        {
+            return _env;
+        }
+
+        jarray ref() const
+        {
+            return _arr;
+        }
+
+    private:
+        JNIEnv* _env;
+        jarray _arr;
+    };
+
+    namespace detail
+    {
+        /**
+         * A partition of work that runs exactly once, either on a worker or on the thread that waits for its result.
+         */
+        template <typename R>
+        struct claimable_task
+        {
+            explicit claimable_task(std::packaged_task<R()>&& task)
+                : task(std::move(task))
+            {}
+
+            /** Runs the task unless another thread has already started it. */
+            void run()
+            {
+                if (!claimed.exchange(true, std::memory_order_acq_rel)) {
+                    task();
+                }
+            }
+
+            std::packaged_task<R()> task;
+            std::atomic<bool> claimed = false;
+        };
+    }
+
+    /**
+     * Splits a view into contiguous partitions, and invokes a function on each partition on the shared native
+     * executor, with the calling thread processing the first partition.
+     *
+     * The function is invoked concurrently. It receives a partition and its offset in the view, and must not call JNI
+     * functions, such that the view may reference a Java array pinned in a critical region. If the function returns a
+     * value, the results are returned in order of partitions, e.g. partial sums that the caller combines.
+     *
+     * Before waiting, the calling thread processes the partitions that no worker has started yet. Progress thus does
+     * not depend on workers, which may be blocked by the critical region held by the caller, e.g. in a JNI call that
+     * allocates Java objects.
+     *
+     * Workers of the shared executor attach to the Java VM when the executor is created. Prefer `pinned_array<T>`,
+     * or use the executor before the array is pinned, such that no thread attaches while a critical region is held.
+     *
+     * @param view Data to process, e.g. a `std::basic_string_view<double>` received from Java.
+     * @param fn A function with the signature `R(std::basic_string_view<T> part, std::size_t offset)`.
+     * @param min_partition_size Minimum number of elements in a partition, such that short views are not split.
+     */
+    template <typename T, typename Function>
+    auto parallel_for_view(std::basic_string_view<T> view, Function&& fn, std::size_t min_partition_size = 65536)
+    {
+        using result_type = std::invoke_result_t<Function&, std::basic_string_view<T>, std::size_t>;
+        using partition_type = detail::claimable_task<result_type>;
+
+        executor& pool = executor::shared();
+        std::size_t max_partitions = executor::is_worker_thread() ? 1 : pool.size() + 1;
+        std::size_t partitions = std::clamp<std::size_t>(view.size() / std::max<std::size_t>(min_partition_size, 1), 1, max_partitions);
+        std::size_t chunk = (view.size() + partitions - 1) / partitions;
+
+        // a partition outlives this call if a worker has not yet dequeued it, but its function is never invoked then
+        std::vector<std::shared_ptr<partition_type>> tail;
+        std::vector<std::future<result_type>> futures;
+        for (std::size_t first = chunk; first < view.size(); first += chunk) {
+            std::size_t count = std::min(chunk, view.size() - first);
+            auto partition = std::make_shared<partition_type>(std::packaged_task<result_type()>(
+                [&fn, view, first, count]() -> result_type {
+                    return fn(view.substr(first, count), first);
+                }
+            ));
+            futures.push_back(partition->task.get_future());
+            pool.post_native([partition]() { partition->run(); });
+            tail.push_back(std::move(partition));
+        }
+
+        auto finish_all = [&tail, &futures]() {
+            {
+                no_jni_scope scope;
+                for (auto&& partition : tail) {
+                    partition->run();
+                }
+            }
+            for (auto&& future : futures) {
+                future.wait();
+            }
+        };
+
+        std::basic_string_view<T> head = view.substr(0, std::min(chunk, view.size()));
+        if constexpr (std::is_void_v<result_type>) {
+            try {
+                no_jni_scope scope;
+                fn(head, 0);
+            } catch (...) {
+                finish_all();
+                throw;
+            }
+            finish_all();
+            for (auto&& future : futures) {
+                future.get();
+            }
+        } else {
+            std::vector<result_type> results;
+            results.reserve(futures.size() + 1);
+            try {
+                no_jni_scope scope;
+                results.push_back(fn(head, 0));
+            } catch (...) {
+                finish_all();
+                throw;
+            }
+            finish_all();
+            for (auto&& future : futures) {
+                results.push_back(future.get());
+            }
+            return results;
+        }
+    }
+
+    /**
+     * Pins a Java primitive array, processes it in parallel as with a view, and releases the pin as soon as all
+     * partitions have finished.
+     */
+    template <typename T, typename Function>
+    auto parallel_for_view(const pinned_array<T>& arr, Function&& fn, std::size_t min_partition_size = 65536)
+    {
+        executor::shared();  // start workers before the array is pinned
+        wrapped_array_view<T> pinned(arr.env(), arr.ref());
+        return parallel_for_view(pinned.view(), std::forward<Function>(fn), min_partition_size);
+    }
+
+    template <typename T>
+    struct JavaPinnedArrayType
+    {
+        using native_type = pinned_array<T>;
+        using java_type = jarray;
+
+        constexpr static std::string_view java_name = JavaArrayViewType<T>::java_name;
+        constexpr static std::string_view sig = JavaArrayViewType<T>::sig;
+        constexpr static std::string_view class_path = sig;
+
+        static native_type native_value(JNIEnv* env, java_type arr)
+        {
+            if (arr == nullptr) {
+                throw JavaNullPointerException(env, msg() << java_name << " is null");
+            }
+            return native_type(env, arr);
+        }
+    };
+
+    template <typename T> struct ArgType<pinned_array<T>> { using type = JavaPinnedArrayType<T>; };
+
+    template <typename T> struct is_call_scoped<pinned_array<T>> : std::true_type {};
+}
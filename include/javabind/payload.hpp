@@ -0,0 +1,603 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "array.hpp"
+#include "record.hpp"
+#include "view.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace javabind
+{
+    /**
+     * Measure of the data that a conversion moves between Java and C++.
+     */
+    enum class PayloadKind
+    {
+        /** Number of bytes in a string, in its native encoding (UTF-8 or UTF-16). */
+        string_bytes,
+        /** Number of elements in a primitive array, an array view, a matrix or an object array. */
+        array_length,
+        /** Number of elements in a list, set or map. */
+        collection_size,
+        /** Number of records, either a single record or the records in an array or collection. */
+        record_count
+    };
+
+    inline constexpr std::array<std::string_view, 4> payload_kind_names = {
+        "string_bytes",
+        "array_length",
+        "collection_size",
+        "record_count"
+    };
+
+    namespace detail
+    {
+        template <typename T, typename = void>
+        struct is_record_type : std::false_type
+        {};
+
+        template <typename T>
+        struct is_record_type<T, std::void_t<typename ArgType<T>::type>> : std::is_same<typename ArgType<T>::type, RecordClassJavaType<T>>
+        {};
+
+        template <typename T>
+        struct is_string_char : std::bool_constant<std::is_same_v<T, char> || std::is_same_v<T, char16_t>>
+        {};
+
+        /**
+         * Sizes of a native value by payload kind, or no size if the type moves no variable amount of data.
+         */
+        template <typename T>
+        struct payload_traits
+        {
+            constexpr static bool measured = is_record_type<T>::value;
+
+            template <typename Recorder>
+            static void measure(const T&, Recorder&& record)
+            {
+                if constexpr (measured) {
+                    record(PayloadKind::record_count, 1);
+                }
+            }
+        };
+
+        template <typename C, typename Traits, typename Allocator>
+        struct payload_traits<std::basic_string<C, Traits, Allocator>>
+        {
+            constexpr static bool measured = is_string_char<C>::value;
+
+            template <typename Recorder>
+            static void measure(const std::basic_string<C, Traits, Allocator>& value, Recorder&& record)
+            {
+                record(PayloadKind::string_bytes, value.size() * sizeof(C));
+            }
+        };
+
+        template <typename C, typename Traits>
+        struct payload_traits<std::basic_string_view<C, Traits>>
+        {
+            constexpr static bool measured = true;
+
+            template <typename Recorder>
+            static void measure(const std::basic_string_view<C, Traits>& value, Recorder&& record)
+            {
+                if constexpr (is_string_char<C>::value) {
+                    record(PayloadKind::string_bytes, value.size() * sizeof(C));
+                } else {
+                    record(PayloadKind::array_length, value.size());
+                }
+            }
+        };
+
+        template <typename T, typename Allocator>
+        struct payload_traits<std::vector<T, Allocator>>
+        {
+            constexpr static bool measured = true;
+
+            template <typename Recorder>
+            static void measure(const std::vector<T, Allocator>& value, Recorder&& record)
+            {
+                if constexpr (std::is_arithmetic_v<T>) {
+                    record(PayloadKind::array_length, value.size());
+                } else {
+                    record(PayloadKind::collection_size, value.size());
+                    if constexpr (is_record_type<T>::value) {
+                        record(PayloadKind::record_count, value.size());
+                    }
+                }
+            }
+        };
+
+        template <typename T>
+        struct payload_traits<array_of<T>>
+        {
+            constexpr static bool measured = true;
+
+            template <typename Recorder>
+            static void measure(const array_of<T>& value, Recorder&& record)
+            {
+                record(PayloadKind::array_length, value.size());
+                if constexpr (is_record_type<T>::value) {
+                    record(PayloadKind::record_count, value.size());
+                }
+            }
+        };
+
+        template <typename T>
+        struct payload_traits<matrix<T>>
+        {
+            constexpr static bool measured = true;
+
+            template <typename Recorder>
+            static void measure(const matrix<T>& value, Recorder&& record)
+            {
+                record(PayloadKind::array_length, value.rows() * value.cols());
+            }
+        };
+
+        /** Sets and maps, with `E` as the element or mapped type. */
+        template <typename C, typename E>
+        struct collection_payload_traits
+        {
+            constexpr static bool measured = true;
+
+            template <typename Recorder>
+            static void measure(const C& value, Recorder&& record)
+            {
+                record(PayloadKind::collection_size, value.size());
+                if constexpr (is_record_type<E>::value) {
+                    record(PayloadKind::record_count, value.size());
+                }
+            }
+        };
+
+        template <typename T, typename Compare, typename Allocator>
+        struct payload_traits<std::set<T, Compare, Allocator>> : collection_payload_traits<std::set<T, Compare, Allocator>, T>
+        {};
+
+        template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+        struct payload_traits<std::unordered_set<T, Hash, KeyEqual, Allocator>> : collection_payload_traits<std::unordered_set<T, Hash, KeyEqual, Allocator>, T>
+        {};
+
+        template <typename K, typename V, typename Compare, typename Allocator>
+        struct payload_traits<std::map<K, V, Compare, Allocator>> : collection_payload_traits<std::map<K, V, Compare, Allocator>, V>
+        {};
+
+        template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+        struct payload_traits<std::unordered_map<K, V, Hash, KeyEqual, Allocator>> : collection_payload_traits<std::unordered_map<K, V, Hash, KeyEqual, Allocator>, V>
+        {};
+
+        template <typename W>
+        struct view_payload_traits
+        {
+            constexpr static bool measured = true;
+
+            template <typename Recorder>
+            static void measure(const W& value, Recorder&& record)
+            {
+                payload_traits<decltype(value.view())>::measure(value.view(), std::forward<Recorder>(record));
+            }
+        };
+
+        template <>
+        struct payload_traits<wrapped_string_view> : view_payload_traits<wrapped_string_view>
+        {};
+
+        template <>
+        struct payload_traits<wrapped_u16string_view> : view_payload_traits<wrapped_u16string_view>
+        {};
+
+        template <typename T>
+        struct payload_traits<wrapped_array_view<T>> : view_payload_traits<wrapped_array_view<T>>
+        {};
+
+        template <typename T>
+        struct payload_traits<std::optional<T>>
+        {
+            constexpr static bool measured = payload_traits<T>::measured;
+
+            template <typename Recorder>
+            static void measure(const std::optional<T>& value, Recorder&& record)
+            {
+                if (value.has_value()) {
+                    payload_traits<T>::measure(*value, std::forward<Recorder>(record));
+                }
+            }
+        };
+    }
+
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+    /**
+     * A histogram of sizes with a bucket for each power of two, updated without locks.
+     *
+     * Bucket 0 counts empty values, and bucket `k` counts sizes in the range [2^(k-1), 2^k).
+     */
+    class payload_histogram
+    {
+    public:
+        constexpr static std::size_t bucket_count = 65;
+
+        void record(std::uint64_t value)
+        {
+            _counts[index_of(value)].fetch_add(1, std::memory_order_relaxed);
+            _sum.fetch_add(value, std::memory_order_relaxed);
+            std::uint64_t max = _max.load(std::memory_order_relaxed);
+            while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+            }
+        }
+
+        std::array<std::uint64_t, bucket_count> counts() const
+        {
+            std::array<std::uint64_t, bucket_count> counts;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                counts[i] = _counts[i].load(std::memory_order_relaxed);
+            }
+            return counts;
+        }
+
+        /** Number of values recorded. */
+        std::uint64_t samples() const
+        {
+            std::uint64_t total = 0;
+            for (auto&& count : _counts) {
+                total += count.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        std::uint64_t sum() const
+        {
+            return _sum.load(std::memory_order_relaxed);
+        }
+
+        std::uint64_t max() const
+        {
+            return _max.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Returns an upper bound on the size below which the given fraction of recorded values fall, within a factor
+         * of two.
+         */
+        std::uint64_t percentile(double quantile) const
+        {
+            std::array<std::uint64_t, bucket_count> values = counts();
+            std::uint64_t total = 0;
+            for (auto&& count : values) {
+                total += count;
+            }
+            if (total == 0) {
+                return 0;
+            }
+            std::uint64_t rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total) + 0.5);
+            if (rank < 1) {
+                rank = 1;
+            } else if (rank > total) {
+                rank = total;
+            }
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                cumulative += values[i];
+                if (cumulative >= rank) {
+                    return i < 64 ? (std::uint64_t(1) << i) - 1 : ~std::uint64_t(0);
+                }
+            }
+            return ~std::uint64_t(0);
+        }
+
+        void reset()
+        {
+            for (auto&& count : _counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+            _sum.store(0, std::memory_order_relaxed);
+            _max.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static std::size_t index_of(std::uint64_t value)
+        {
+            if (value == 0) {
+                return 0;
+            }
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<std::size_t>(index) + 1;
+#else
+            return static_cast<std::size_t>(64 - __builtin_clzll(value));
+#endif
+        }
+
+        std::array<std::atomic<std::uint64_t>, bucket_count> _counts = {};
+        std::atomic<std::uint64_t> _sum = 0;
+        std::atomic<std::uint64_t> _max = 0;
+    };
+
+    struct PayloadStatistics;
+
+    /**
+     * Samples calls to native function bindings, and records the size of the data that their arguments and results
+     * carry in histograms per binding and payload kind.
+     *
+     * A call is sampled with a probability of 1 / `sample_interval`. Within a sampled call, each argument is measured
+     * after it has been converted into a native value, and the result before it is converted into a Java value. Only
+     * the top-level value is measured, e.g. a list of strings counts towards the collection size but not the string
+     * bytes.
+     */
+    class PayloadProfiler
+    {
+    public:
+        /** A sampled call records its arguments and result in histograms for each direction and payload kind. */
+        using histograms = std::array<payload_histogram, payload_kind_names.size()>;
+
+        /**
+         * Average number of calls per sampled call; 1 records every call. Defaults to 16.
+         */
+        inline static std::atomic<std::uint32_t> sample_interval = 16;
+
+        /**
+         * A call to a native function binding, which is either sampled or ignored.
+         */
+        class call_scope
+        {
+        public:
+            explicit call_scope(PayloadStatistics& stats)
+                : _outer(_current)
+            {
+                _current = sample() ? &stats : nullptr;
+            }
+
+            call_scope(const call_scope&) = delete;
+            call_scope& operator=(const call_scope&) = delete;
+
+            ~call_scope()
+            {
+                _current = _outer;
+            }
+
+        private:
+            PayloadStatistics* _outer;
+        };
+
+        /** Records the size of an argument that has been converted into a native value, if the call is sampled. */
+        template <typename T>
+        static void argument(const T& value);
+
+        /** Records the size of a native result that is about to be converted into a Java value, if the call is sampled. */
+        template <typename T>
+        static void result(const T& value);
+
+        static void add(PayloadStatistics* stats)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _statistics.push_back(stats);
+        }
+
+        /**
+         * Associates a human-readable name with the entry point of a native function binding.
+         */
+        static void name(const void* binding, std::string name)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _names[binding] = std::move(name);
+        }
+
+        /**
+         * Returns the bucket counts of a histogram, or an empty optional if the binding has not been sampled.
+         *
+         * @param binding Name of the binding, e.g. `hu.info.hunyadi.test.StaticSample.pass_string`.
+         * @param is_result True for the histogram of results, false for arguments.
+         */
+        static std::optional<std::array<std::uint64_t, payload_histogram::bucket_count>> histogram(std::string_view binding, bool is_result, PayloadKind kind);
+
+        /**
+         * Writes the number of samples, the mean, the median, the 99th percentile and the maximum of each non-empty
+         * histogram, one line per binding, direction and payload kind.
+         */
+        static void report(std::ostream& os);
+
+        static void reset();
+
+    private:
+        static bool sample()
+        {
+            std::uint32_t interval = sample_interval.load(std::memory_order_relaxed);
+            if (interval <= 1) {
+                return true;
+            }
+
+            // xorshift generator, seeded differently on each thread
+            std::uint32_t x = _random;
+            if (x == 0) {
+                x = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(&_random)) | 1;
+            }
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            _random = x;
+            return x % interval == 0;
+        }
+
+        /** Must be called with the mutex held. */
+        static std::string_view name_of(const void* binding)
+        {
+            auto it = _names.find(binding);
+            if (it == _names.end()) {
+                return "(unknown)";
+            }
+            return it->second;
+        }
+
+        inline static std::mutex _mutex;
+        inline static std::vector<PayloadStatistics*> _statistics;
+        inline static std::map<const void*, std::string> _names;
+        inline static thread_local PayloadStatistics* _current = nullptr;
+        inline static thread_local std::uint32_t _random = 0;
+    };
+
+    /**
+     * Payload histograms of a single native function binding, registered with the profiler when first used.
+     */
+    struct PayloadStatistics
+    {
+        explicit PayloadStatistics(const void* binding)
+            : binding(binding)
+        {
+            PayloadProfiler::add(this);
+        }
+
+        PayloadStatistics(const PayloadStatistics&) = delete;
+        PayloadStatistics& operator=(const PayloadStatistics&) = delete;
+
+        /** Entry point of the native function binding. */
+        const void* binding;
+        PayloadProfiler::histograms arguments;
+        PayloadProfiler::histograms results;
+
+        template <typename T>
+        static void measure(PayloadProfiler::histograms& target, const T& value)
+        {
+            using traits = detail::payload_traits<std::remove_cv_t<std::remove_reference_t<T>>>;
+            if constexpr (traits::measured) {
+                traits::measure(value, [&target](PayloadKind kind, std::size_t size) {
+                    target[static_cast<std::size_t>(kind)].record(static_cast<std::uint64_t>(size));
+                });
+            }
+        }
+    };
+
+    template <typename T>
+    void PayloadProfiler::argument(const T& value)
+    {
+        if (_current != nullptr) {
+            PayloadStatistics::measure(_current->arguments, value);
+        }
+    }
+
+    template <typename T>
+    void PayloadProfiler::result(const T& value)
+    {
+        if (_current != nullptr) {
+            PayloadStatistics::measure(_current->results, value);
+        }
+    }
+
+    inline std::optional<std::array<std::uint64_t, payload_histogram::bucket_count>> PayloadProfiler::histogram(std::string_view binding, bool is_result, PayloadKind kind)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (PayloadStatistics* stats : _statistics) {
+            if (name_of(stats->binding) == binding) {
+                const histograms& target = is_result ? stats->results : stats->arguments;
+                return target[static_cast<std::size_t>(kind)].counts();
+            }
+        }
+        return std::nullopt;
+    }
+
+    inline void PayloadProfiler::report(std::ostream& os)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (PayloadStatistics* stats : _statistics) {
+            for (bool is_result : { false, true }) {
+                const histograms& target = is_result ? stats->results : stats->arguments;
+                for (std::size_t k = 0; k < target.size(); ++k) {
+                    std::uint64_t samples = target[k].samples();
+                    if (samples == 0) {
+                        continue;
+                    }
+                    os << name_of(stats->binding) << " " << (is_result ? "result" : "argument") << " " << payload_kind_names[k] << ":"
+                        << " samples=" << samples
+                        << " mean=" << target[k].sum() / samples
+                        << " p50<=" << target[k].percentile(0.5)
+                        << " p99<=" << target[k].percentile(0.99)
+                        << " max=" << target[k].max()
+                        << "\n";
+                }
+            }
+        }
+    }
+
+    inline void PayloadProfiler::reset()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (PayloadStatistics* stats : _statistics) {
+            for (auto&& h : stats->arguments) {
+                h.reset();
+            }
+            for (auto&& h : stats->results) {
+                h.reset();
+            }
+        }
+    }
+
+    /**
+     * Returns the payload statistics associated with an adapter type.
+     */
+    template <typename Adapter>
+    PayloadStatistics& payload_statistics_of()
+    {
+        static PayloadStatistics stats(reinterpret_cast<const void*>(Adapter::invoke));
+        return stats;
+    }
+#else
+    /**
+     * Placeholder for payload profiling when instrumentation is disabled, optimized away entirely.
+     */
+    struct PayloadStatistics
+    {};
+
+    struct PayloadProfiler
+    {
+        struct call_scope
+        {
+            explicit call_scope(PayloadStatistics&)
+            {}
+        };
+
+        template <typename T>
+        static void argument(const T&)
+        {}
+
+        template <typename T>
+        static void result(const T&)
+        {}
+    };
+
+    template <typename Adapter>
+    PayloadStatistics& payload_statistics_of()
+    {
+        static PayloadStatistics stats;
+        return stats;
+    }
+#endif
+}
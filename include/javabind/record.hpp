@@ -9,7 +9,9 @@
  */
 
 #pragma once
+#include "global.hpp"
 #include "object.hpp"
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -30,6 +32,8 @@ namespace javabind
         void (*get_by_value)(JNIEnv* env, jobject obj, Field& fld, const void* native_object_ptr);
         /** A function that persists a value to a Java object field. */
         void (*set_by_value)(JNIEnv* env, jobject obj, Field& fld, void* native_object_ptr);
+        /** Number of local references held at the same time while converting the field value. */
+        jint local_capacity;
     };
 
     /**
@@ -59,45 +63,69 @@ namespace javabind
             if (obj == nullptr) {
                 throw JavaNullPointerException(env, msg() << java_name << " is null");
             }
-            LocalClassRef objClass(env, obj);
 
-            T native_object = T();
-            auto&& bindings = FieldBindings::value[sig];
-            for (auto&& binding : bindings) {
-                Field fld = objClass.getField(binding.name, binding.signature);
-                binding.set_by_value(env, obj, fld, &native_object);
-            }
-            return native_object;
+            const FieldBindings::value_type& bindings = field_bindings();
+            const GlobalClassRef& cls = record_class(env);
+            return with_local_frame(env, frame_capacity(bindings), [&]() {
+                T native_object = T();
+                for (auto&& binding : bindings) {
+                    Field fld = cls.getField(env, binding.name, binding.signature);
+                    binding.set_by_value(env, obj, fld, &native_object);
+                }
+                return native_object;
+            });
         }
 
         static jobject java_value(JNIEnv* env, const T& native_object)
         {
-            LocalClassRef objClass(env, sig);
-            jobject obj = env->AllocObject(objClass.ref());
-            if (obj == nullptr) {
-                throw JavaException(env);
-            }
+            const FieldBindings::value_type& bindings = field_bindings();
+            const GlobalClassRef& cls = record_class(env);
+            return with_local_frame(env, frame_capacity(bindings), [&]() {
+                jobject obj = env->AllocObject(cls.ref());
+                if (obj == nullptr) {
+                    throw JavaException(env);
+                }
 
-            auto&& bindings = FieldBindings::value[sig];
-            for (auto&& binding : bindings) {
-                Field fld = objClass.getField(binding.name, binding.signature);
-                binding.get_by_value(env, obj, fld, &native_object);
-            }
-            return obj;
+                for (auto&& binding : bindings) {
+                    Field fld = cls.getField(env, binding.name, binding.signature);
+                    binding.get_by_value(env, obj, fld, &native_object);
+                }
+                return obj;
+            });
         }
 
-        static jarray java_array_value(JNIEnv* env, const native_type* ptr, std::size_t len)
+    private:
+        /**
+         * Returns the bindings of the record fields, which are registered before any conversion takes place.
+         *
+         * The map of bindings is not modified after registration, and may be read by several threads at the same time.
+         */
+        static const FieldBindings::value_type& field_bindings()
         {
-            LocalClassRef elementClass(env, ArgType<T>::class_name);
-            jobjectArray arr = env->NewObjectArray(len, elementClass.ref(), nullptr);
-            if (arr == nullptr) {
-                throw JavaException(env);
+            auto it = FieldBindings::value.find(sig);
+            if (it == FieldBindings::value.end()) {
+                throw std::logic_error(msg() << "Record class " << java_name << " has not been registered.");
             }
-            for (std::size_t k = 0; k < len; ++k) {
-                LocalObjectRef objElement(env, ArgType<T>::java_value(env, ptr[k]));
-                env->SetObjectArrayElement(arr, k, objElement.ref());
+            return it->second;
+        }
+
+        /**
+         * Returns the record class, looked up only once.
+         */
+        static const GlobalClassRef& record_class(JNIEnv* env)
+        {
+            static const GlobalClassRef cls(env, LocalClassRef(env, sig));
+            return cls;
+        }
+
+        /** Local references held at the same time while converting a record: object and a field value. */
+        static jint frame_capacity(const FieldBindings::value_type& bindings)
+        {
+            jint field_capacity = 0;
+            for (auto&& binding : bindings) {
+                field_capacity = std::max(field_capacity, binding.local_capacity);
             }
-            return arr;
+            return 1 + field_capacity;
         }
     };
 }
@@ -58,7 +58,21 @@ namespace javabind
             return join_sep_v<comma, single_param_display<Args, Is>::value...>;
         }
 
+        template<std::size_t I>
+        struct single_param_name
+        {
+            static constexpr std::string_view arg_name = "arg";
+            static constexpr std::string_view value = join_v<arg_name, to_string<I>::value>;
+        };
+
+        template <std::size_t... Is>
+        static constexpr std::string_view make_param_names(std::index_sequence<Is...>) {
+            return join_sep_v<comma, single_param_name<Is>::value...>;
+        }
+
         constexpr static std::string_view param_display = make_param_display(std::index_sequence_for<Args...>{});
+        /** Parameter names as they appear in `param_display`, used in forwarding calls. */
+        constexpr static std::string_view param_names = make_param_names(std::index_sequence_for<Args...>{});
         constexpr static std::string_view return_display = arg_type_t<R>::java_name;
     };
 
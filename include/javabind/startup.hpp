@@ -0,0 +1,204 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <ios>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace javabind
+{
+    /**
+     * A step of extension module initialization in `JNI_OnLoad`, in the order in which the steps run.
+     */
+    enum class StartupPhase
+    {
+        /** The user-defined function in which bindings are registered. */
+        initializer,
+        /** Registering native callbacks and looking up bundled helper classes. */
+        callback_registry,
+        /** Finding each native class and registering its native methods. */
+        function_registration,
+        /** Finding each record class and validating its fields. */
+        record_validation,
+        /** Finding each enum class and looking up its values. */
+        enum_initialization
+    };
+
+    inline constexpr std::array<std::string_view, 5> startup_phase_names = {
+        "initializer",
+        "callback_registry",
+        "function_registration",
+        "record_validation",
+        "enum_initialization"
+    };
+
+    /**
+     * Time spent in a phase of initialization, either for a single class or for the phase as a whole.
+     */
+    struct StartupTiming
+    {
+        StartupPhase phase;
+        /** Fully qualified Java class name, or empty if the phase is not broken down by class. */
+        std::string class_name;
+        std::chrono::nanoseconds duration;
+    };
+
+    /**
+     * Time spent initializing the extension module, per phase and per class.
+     */
+    struct StartupProfile
+    {
+        /** Timings in the order in which they have been measured. */
+        std::vector<StartupTiming> timings;
+
+        /** Total time spent in a phase. */
+        std::chrono::nanoseconds total(StartupPhase phase) const
+        {
+            std::chrono::nanoseconds duration{ 0 };
+            for (auto&& timing : timings) {
+                if (timing.phase == phase) {
+                    duration += timing.duration;
+                }
+            }
+            return duration;
+        }
+
+        /** Total time spent in all phases. */
+        std::chrono::nanoseconds total() const
+        {
+            std::chrono::nanoseconds duration{ 0 };
+            for (auto&& timing : timings) {
+                duration += timing.duration;
+            }
+            return duration;
+        }
+
+        /**
+         * Prints the total time of each phase, followed by the classes that took the longest to initialize.
+         *
+         * @param max_classes The maximum number of classes to list.
+         */
+        void print(std::ostream& os, std::size_t max_classes = 10) const
+        {
+            auto millis = [](std::chrono::nanoseconds duration) {
+                return std::chrono::duration<double, std::milli>(duration).count();
+            };
+
+            std::ios_base::fmtflags flags = os.flags();
+            std::streamsize precision = os.precision();
+            os << std::fixed << std::setprecision(3);
+            os << "javabind startup: " << millis(total()) << " ms\n";
+            for (std::size_t i = 0; i < startup_phase_names.size(); ++i) {
+                StartupPhase phase = static_cast<StartupPhase>(i);
+                std::size_t classes = static_cast<std::size_t>(std::count_if(timings.begin(), timings.end(), [phase](const StartupTiming& timing) {
+                    return timing.phase == phase && !timing.class_name.empty();
+                }));
+                os << "  " << std::left << std::setw(24) << startup_phase_names[i] << std::right << std::setw(12) << millis(total(phase)) << " ms";
+                if (classes > 0) {
+                    os << " (" << classes << " classes)";
+                }
+                os << "\n";
+            }
+
+            std::vector<StartupTiming> slowest;
+            std::copy_if(timings.begin(), timings.end(), std::back_inserter(slowest), [](const StartupTiming& timing) {
+                return !timing.class_name.empty();
+            });
+            std::stable_sort(slowest.begin(), slowest.end(), [](const StartupTiming& left, const StartupTiming& right) {
+                return left.duration > right.duration;
+            });
+            if (slowest.size() > max_classes) {
+                slowest.resize(max_classes);
+            }
+            if (!slowest.empty()) {
+                os << "  slowest classes:\n";
+            }
+            for (auto&& timing : slowest) {
+                os << "    " << std::left << std::setw(24) << startup_phase_names[static_cast<std::size_t>(timing.phase)]
+                    << std::right << std::setw(12) << millis(timing.duration) << " ms  " << timing.class_name << "\n";
+            }
+            os.flags(flags);
+            os.precision(precision);
+            os << std::flush;
+        }
+    };
+
+    /**
+     * Options that govern reporting the time spent initializing the extension module.
+     *
+     * Options are typically set in the user-defined initializer function, which runs first in `JNI_OnLoad`. Profiling
+     * is disabled by default.
+     */
+    struct startup_options
+    {
+        /** Prints the startup profile to the Java standard output when initialization has completed. */
+        inline static bool print_profile = false;
+
+        /** Invoked with the startup profile when initialization has completed, if set. */
+        inline static std::function<void(const StartupProfile&)> profile_handler;
+
+        static bool enabled()
+        {
+            return print_profile || profile_handler != nullptr;
+        }
+    };
+
+    /**
+     * Measures the time of consecutive steps of initialization.
+     */
+    struct StartupProfiler
+    {
+        using clock_type = std::chrono::steady_clock;
+
+        /** Starts measuring a step. */
+        void start()
+        {
+            _start = clock_type::now();
+        }
+
+        /**
+         * Records the time elapsed since the step has started, if profiling is enabled.
+         *
+         * @param class_name A fully qualified class name with components separated by `.` or `/`, or a type signature.
+         */
+        void stop(StartupPhase phase, std::string_view class_name = {})
+        {
+            if (!startup_options::enabled()) {
+                return;
+            }
+            auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - _start);
+            if (class_name.size() >= 2 && class_name.front() == 'L' && class_name.back() == ';') {
+                class_name = class_name.substr(1, class_name.size() - 2);
+            }
+            std::string name(class_name);
+            std::replace(name.begin(), name.end(), '/', '.');
+            _profile.timings.push_back({ phase, std::move(name), duration });
+        }
+
+        const StartupProfile& profile() const
+        {
+            return _profile;
+        }
+
+    private:
+        clock_type::time_point _start = clock_type::now();
+        StartupProfile _profile;
+    };
+}
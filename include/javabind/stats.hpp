@@ -0,0 +1,519 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "accounting.hpp"
+#include "local.hpp"
+#include "payload.hpp"
+#include "tracking.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace javabind
+{
+#if defined(JAVABIND_STATISTICS)
+    /**
+     * A histogram of durations in nanoseconds with buckets of exponentially increasing width, in the style of HDR
+     * histograms.
+     *
+     * Each power of two is split into a fixed number of linear sub-buckets, which bounds the relative error of a
+     * percentile to 1/8 at a constant memory footprint. Recording a value is a single relaxed atomic increment.
+     */
+    class latency_histogram
+    {
+    public:
+        constexpr static unsigned sub_bucket_bits = 3;
+        constexpr static std::size_t sub_bucket_count = std::size_t(1) << sub_bucket_bits;
+        constexpr static std::size_t bucket_count = 64 * sub_bucket_count;
+
+        void record(std::uint64_t value)
+        {
+            _counts[index_of(value)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * Returns an upper bound on the value below which the given fraction of recorded values fall.
+         *
+         * @param quantile A value between 0.0 and 1.0, e.g. 0.99 for the 99th percentile.
+         */
+        std::uint64_t percentile(double quantile) const
+        {
+            std::array<std::uint64_t, bucket_count> counts;
+            std::uint64_t total = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                counts[i] = _counts[i].load(std::memory_order_relaxed);
+                total += counts[i];
+            }
+            if (total == 0) {
+                return 0;
+            }
+
+            std::uint64_t rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total) + 0.5);
+            if (rank < 1) {
+                rank = 1;
+            } else if (rank > total) {
+                rank = total;
+            }
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                cumulative += counts[i];
+                if (cumulative >= rank) {
+                    return upper_bound_of(i);
+                }
+            }
+            return upper_bound_of(bucket_count - 1);
+        }
+
+        void reset()
+        {
+            for (auto&& count : _counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        static unsigned most_significant_bit(std::uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<unsigned>(index);
+#else
+            return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        }
+
+        static std::size_t index_of(std::uint64_t value)
+        {
+            if (value < sub_bucket_count) {
+                return static_cast<std::size_t>(value);
+            }
+            unsigned shift = most_significant_bit(value) - sub_bucket_bits;
+            std::size_t sub_bucket = static_cast<std::size_t>(value >> shift) & (sub_bucket_count - 1);
+            return (shift + 1) * sub_bucket_count + sub_bucket;
+        }
+
+        static std::uint64_t upper_bound_of(std::size_t index)
+        {
+            if (index < sub_bucket_count) {
+                return index;
+            }
+            std::size_t shift = index / sub_bucket_count - 1;
+            std::size_t sub_bucket = index % sub_bucket_count;
+            return ((std::uint64_t(sub_bucket_count + sub_bucket + 1)) << shift) - 1;
+        }
+
+        std::array<std::atomic<std::uint64_t>, bucket_count> _counts = {};
+    };
+
+    /**
+     * Call counters and timings of a single native function binding, updated without locks.
+     */
+    struct BindingStatistics
+    {
+        std::atomic<std::uint64_t> calls = 0;
+        std::atomic<std::uint64_t> exceptions = 0;
+        /** Time spent converting Java arguments into native values. */
+        std::atomic<std::uint64_t> argument_nanos = 0;
+        /** Time spent in the native function body. */
+        std::atomic<std::uint64_t> body_nanos = 0;
+        /** Time spent converting the native result into a Java value. */
+        std::atomic<std::uint64_t> result_nanos = 0;
+        /** Distribution of the total time spent in a call. */
+        latency_histogram latency;
+
+        void reset()
+        {
+            calls.store(0, std::memory_order_relaxed);
+            exceptions.store(0, std::memory_order_relaxed);
+            argument_nanos.store(0, std::memory_order_relaxed);
+            body_nanos.store(0, std::memory_order_relaxed);
+            result_nanos.store(0, std::memory_order_relaxed);
+            latency.reset();
+        }
+    };
+
+    /**
+     * Measures the phases of a single call to a native function binding, and adds them to the binding statistics
+     * when the call returns.
+     */
+    class statistics_scope
+    {
+        using clock = std::chrono::steady_clock;
+
+    public:
+        explicit statistics_scope(BindingStatistics& stats)
+            : _stats(stats)
+            , _start(clock::now())
+        {}
+
+        statistics_scope(const statistics_scope&) = delete;
+        statistics_scope& operator=(const statistics_scope&) = delete;
+
+        ~statistics_scope()
+        {
+            clock::time_point end = clock::now();
+            clock::time_point converted = _stage > 0 ? _converted : end;
+            clock::time_point returned = _stage > 1 ? _returned : end;
+
+            _stats.calls.fetch_add(1, std::memory_order_relaxed);
+            if (_failed) {
+                _stats.exceptions.fetch_add(1, std::memory_order_relaxed);
+            }
+            _stats.argument_nanos.fetch_add(nanos(_start, converted), std::memory_order_relaxed);
+            _stats.body_nanos.fetch_add(nanos(converted, returned), std::memory_order_relaxed);
+            _stats.result_nanos.fetch_add(nanos(returned, end), std::memory_order_relaxed);
+            _stats.latency.record(nanos(_start, end));
+        }
+
+        /**
+         * Invokes the native function body on arguments that have already been converted.
+         */
+        template <typename Function, typename... Args>
+        decltype(auto) invoke(Function&& fn, Args&&... args)
+        {
+            _converted = clock::now();
+            _stage = 1;
+            if constexpr (std::is_void_v<std::invoke_result_t<Function, Args...>>) {
+                std::forward<Function>(fn)(std::forward<Args>(args)...);
+                _returned = clock::now();
+                _stage = 2;
+            } else {
+                decltype(auto) result = std::forward<Function>(fn)(std::forward<Args>(args)...);
+                _returned = clock::now();
+                _stage = 2;
+                return result;
+            }
+        }
+
+        void failed()
+        {
+            _failed = true;
+        }
+
+    private:
+        static std::uint64_t nanos(clock::time_point from, clock::time_point to)
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+        }
+
+        BindingStatistics& _stats;
+        clock::time_point _start;
+        clock::time_point _converted;
+        clock::time_point _returned;
+        int _stage = 0;
+        bool _failed = false;
+    };
+#else
+    /**
+     * Placeholder for call statistics when instrumentation is disabled, optimized away entirely.
+     */
+    struct BindingStatistics
+    {};
+
+    class statistics_scope
+    {
+    public:
+        explicit statistics_scope(BindingStatistics&)
+        {}
+
+        template <typename Function, typename... Args>
+        decltype(auto) invoke(Function&& fn, Args&&... args)
+        {
+            return std::forward<Function>(fn)(std::forward<Args>(args)...);
+        }
+
+        void failed()
+        {}
+    };
+#endif
+
+    /**
+     * Returns the statistics object associated with an adapter type.
+     */
+    template <typename Adapter>
+    BindingStatistics& statistics_of()
+    {
+        static BindingStatistics stats;
+        return stats;
+    }
+
+    /**
+     * Registered native function bindings whose calls are counted, populated when the extension module is loaded.
+     */
+    struct StatisticsRegistry
+    {
+        struct Entry
+        {
+            std::string name;
+            BindingStatistics* statistics;
+        };
+
+        inline static std::vector<Entry> value;
+
+        static void add(std::string name, BindingStatistics* statistics)
+        {
+            if (statistics != nullptr) {
+                value.push_back({ std::move(name), statistics });
+            }
+        }
+    };
+
+    /**
+     * Implements the native methods of the bundled Java class `NativeStats`.
+     */
+    struct StatisticsHandler
+    {
+        static jboolean enabled(JNIEnv*, jclass)
+        {
+#if defined(JAVABIND_STATISTICS)
+            return JNI_TRUE;
+#else
+            return JNI_FALSE;
+#endif
+        }
+
+        static jobjectArray names(JNIEnv* env, jclass)
+        {
+            LocalClassRef stringClass(env, "java/lang/String");
+            jobjectArray arr = env->NewObjectArray(static_cast<jsize>(StatisticsRegistry::value.size()), stringClass.ref(), nullptr);
+            if (arr == nullptr) {
+                return nullptr;
+            }
+            for (std::size_t i = 0; i < StatisticsRegistry::value.size(); ++i) {
+                LocalObjectRef name(env, env->NewStringUTF(StatisticsRegistry::value[i].name.c_str()));
+                env->SetObjectArrayElement(arr, static_cast<jsize>(i), name.ref());
+            }
+            return arr;
+        }
+
+        static jlongArray counters(JNIEnv* env, jclass, jint index)
+        {
+            jlong values[5] = {};
+#if defined(JAVABIND_STATISTICS)
+            if (index >= 0 && static_cast<std::size_t>(index) < StatisticsRegistry::value.size()) {
+                const BindingStatistics& stats = *StatisticsRegistry::value[index].statistics;
+                values[0] = static_cast<jlong>(stats.calls.load(std::memory_order_relaxed));
+                values[1] = static_cast<jlong>(stats.exceptions.load(std::memory_order_relaxed));
+                values[2] = static_cast<jlong>(stats.argument_nanos.load(std::memory_order_relaxed));
+                values[3] = static_cast<jlong>(stats.body_nanos.load(std::memory_order_relaxed));
+                values[4] = static_cast<jlong>(stats.result_nanos.load(std::memory_order_relaxed));
+            }
+#else
+            (void)index;
+#endif
+            jlongArray arr = env->NewLongArray(5);
+            if (arr != nullptr) {
+                env->SetLongArrayRegion(arr, 0, 5, values);
+            }
+            return arr;
+        }
+
+        static jlong percentile(JNIEnv*, jclass, jint index, jdouble quantile)
+        {
+#if defined(JAVABIND_STATISTICS)
+            if (index >= 0 && static_cast<std::size_t>(index) < StatisticsRegistry::value.size()) {
+                return static_cast<jlong>(StatisticsRegistry::value[index].statistics->latency.percentile(quantile));
+            }
+#else
+            (void)index;
+            (void)quantile;
+#endif
+            return 0;
+        }
+
+        static void reset(JNIEnv*, jclass)
+        {
+#if defined(JAVABIND_STATISTICS)
+            for (auto&& entry : StatisticsRegistry::value) {
+                entry.statistics->reset();
+            }
+#endif
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            JNIAccounting::reset();
+#endif
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+            LocalRefTracker::reset();
+#endif
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+            PayloadProfiler::reset();
+#endif
+        }
+
+        static jboolean localRefsEnabled(JNIEnv*, jclass)
+        {
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+            return JNI_TRUE;
+#else
+            return JNI_FALSE;
+#endif
+        }
+
+        static jstring localRefs(JNIEnv* env, jclass)
+        {
+            std::ostringstream os;
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+            LocalRefTracker::report(os);
+#endif
+            return env->NewStringUTF(os.str().c_str());
+        }
+
+        static jlongArray localRefCounts(JNIEnv* env, jclass, jstring binding)
+        {
+            jlong values[3] = {};
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+            if (binding != nullptr) {
+                const char* binding_chars = env->GetStringUTFChars(binding, nullptr);
+                LocalRefTracker::Record record = LocalRefTracker::record_of(binding_chars);
+                env->ReleaseStringUTFChars(binding, binding_chars);
+                values[0] = static_cast<jlong>(record.calls);
+                values[1] = static_cast<jlong>(record.peak);
+                values[2] = static_cast<jlong>(record.leaked);
+            }
+#else
+            (void)binding;
+#endif
+            jlongArray arr = env->NewLongArray(3);
+            if (arr != nullptr) {
+                env->SetLongArrayRegion(arr, 0, 3, values);
+            }
+            return arr;
+        }
+
+        static jboolean jniCallsEnabled(JNIEnv*, jclass)
+        {
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            return JNI_TRUE;
+#else
+            return JNI_FALSE;
+#endif
+        }
+
+        static jstring jniCalls(JNIEnv* env, jclass)
+        {
+            std::ostringstream os;
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            JNIAccounting::report(os);
+#endif
+            return env->NewStringUTF(os.str().c_str());
+        }
+
+        static jlong jniCallCount(JNIEnv* env, jclass, jstring binding, jstring function)
+        {
+#if defined(JAVABIND_JNI_ACCOUNTING)
+            if (binding == nullptr || function == nullptr) {
+                return 0;
+            }
+            const char* binding_chars = env->GetStringUTFChars(binding, nullptr);
+            const char* function_chars = env->GetStringUTFChars(function, nullptr);
+            jlong count = static_cast<jlong>(JNIAccounting::count(binding_chars, function_chars));
+            env->ReleaseStringUTFChars(function, function_chars);
+            env->ReleaseStringUTFChars(binding, binding_chars);
+            return count;
+#else
+            (void)env;
+            (void)binding;
+            (void)function;
+            return 0;
+#endif
+        }
+
+        static jstring payloadSizes(JNIEnv* env, jclass)
+        {
+            std::ostringstream os;
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+            PayloadProfiler::report(os);
+#endif
+            return env->NewStringUTF(os.str().c_str());
+        }
+
+        static jlongArray payloadHistogram(JNIEnv* env, jclass, jstring binding, jboolean result, jstring kind)
+        {
+            jlong values[65] = {};
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+            static_assert(std::size(values) == payload_histogram::bucket_count);
+            if (binding != nullptr && kind != nullptr) {
+                const char* binding_chars = env->GetStringUTFChars(binding, nullptr);
+                const char* kind_chars = env->GetStringUTFChars(kind, nullptr);
+                for (std::size_t k = 0; k < payload_kind_names.size(); ++k) {
+                    if (payload_kind_names[k] != kind_chars) {
+                        continue;
+                    }
+                    auto counts = PayloadProfiler::histogram(binding_chars, result == JNI_TRUE, static_cast<PayloadKind>(k));
+                    if (counts.has_value()) {
+                        for (std::size_t i = 0; i < counts->size(); ++i) {
+                            values[i] = static_cast<jlong>((*counts)[i]);
+                        }
+                    }
+                }
+                env->ReleaseStringUTFChars(kind, kind_chars);
+                env->ReleaseStringUTFChars(binding, binding_chars);
+            }
+#else
+            (void)binding;
+            (void)result;
+            (void)kind;
+#endif
+            jlongArray arr = env->NewLongArray(65);
+            if (arr != nullptr) {
+                env->SetLongArrayRegion(arr, 0, 65, values);
+            }
+            return arr;
+        }
+
+        static void setPayloadSampleInterval(JNIEnv*, jclass, jint interval)
+        {
+#if defined(JAVABIND_PAYLOAD_PROFILING)
+            PayloadProfiler::sample_interval.store(interval > 1 ? static_cast<std::uint32_t>(interval) : 1, std::memory_order_relaxed);
+#else
+            (void)interval;
+#endif
+        }
+
+        /**
+         * Registers native methods of `NativeStats` if the class is visible to the class loader.
+         */
+        static jint register_natives(JNIEnv* env)
+        {
+            LocalClassRef cls(env, "hu/info/hunyadi/javabind/NativeStats", std::nothrow);
+            if (cls.ref() == nullptr) {
+                env->ExceptionClear();
+                return JNI_OK;  // statistics are not queried from Java
+            }
+            JNINativeMethod methods[] = {
+                { const_cast<char*>("enabled"), const_cast<char*>("()Z"), reinterpret_cast<void*>(enabled) },
+                { const_cast<char*>("names"), const_cast<char*>("()[Ljava/lang/String;"), reinterpret_cast<void*>(names) },
+                { const_cast<char*>("counters"), const_cast<char*>("(I)[J"), reinterpret_cast<void*>(counters) },
+                { const_cast<char*>("percentile"), const_cast<char*>("(ID)J"), reinterpret_cast<void*>(percentile) },
+                { const_cast<char*>("reset"), const_cast<char*>("()V"), reinterpret_cast<void*>(reset) },
+                { const_cast<char*>("jniCallsEnabled"), const_cast<char*>("()Z"), reinterpret_cast<void*>(jniCallsEnabled) },
+                { const_cast<char*>("jniCalls"), const_cast<char*>("()Ljava/lang/String;"), reinterpret_cast<void*>(jniCalls) },
+                { const_cast<char*>("jniCallCount"), const_cast<char*>("(Ljava/lang/String;Ljava/lang/String;)J"), reinterpret_cast<void*>(jniCallCount) },
+                { const_cast<char*>("localRefsEnabled"), const_cast<char*>("()Z"), reinterpret_cast<void*>(localRefsEnabled) },
+                { const_cast<char*>("localRefs"), const_cast<char*>("()Ljava/lang/String;"), reinterpret_cast<void*>(localRefs) },
+                { const_cast<char*>("localRefCounts"), const_cast<char*>("(Ljava/lang/String;)[J"), reinterpret_cast<void*>(localRefCounts) },
+                { const_cast<char*>("payloadSizes"), const_cast<char*>("()Ljava/lang/String;"), reinterpret_cast<void*>(payloadSizes) },
+                { const_cast<char*>("payloadHistogram"), const_cast<char*>("(Ljava/lang/String;ZLjava/lang/String;)[J"), reinterpret_cast<void*>(payloadHistogram) },
+                { const_cast<char*>("setPayloadSampleInterval"), const_cast<char*>("(I)V"), reinterpret_cast<void*>(setPayloadSampleInterval) }
+            };
+            return env->RegisterNatives(cls.ref(), methods, static_cast<jint>(std::size(methods)));
+        }
+    };
+}
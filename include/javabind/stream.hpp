@@ -0,0 +1,367 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include "collection.hpp"
+#include "function.hpp"
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+namespace javabind
+{
+    /**
+     * Default number of elements transferred from native code to Java in a single call.
+     */
+    constexpr static std::size_t stream_batch_size = 1024;
+
+    /**
+     * Base class of native element sources exposed to Java as a `java.util.Spliterator`.
+     *
+     * Elements are transferred in batches to amortize the cost of crossing the native-to-Java boundary.
+     */
+    struct StreamSource : BaseCallback
+    {
+        /** Spliterator characteristics, as defined in `java.util.Spliterator`. */
+        constexpr static jint ordered = 0x00000010;
+        constexpr static jint sized = 0x00000040;
+        constexpr static jint nonnull = 0x00000100;
+        constexpr static jint immutable = 0x00000400;
+        constexpr static jint subsized = 0x00004000;
+
+        /** Returns at most `count` elements as a Java object array, or `null` if no elements remain. */
+        virtual jobjectArray fetch(JNIEnv* env, jint count) = 0;
+
+        /** Splits off a prefix of the remaining elements into a new source, or returns `nullptr` if not supported. */
+        virtual StreamSource* split() = 0;
+
+        /** Returns the exact number of remaining elements, or `Long.MAX_VALUE` if unknown. */
+        virtual jlong remaining() const = 0;
+
+        /** Returns the spliterator characteristics of this source. */
+        virtual jint characteristics() const = 0;
+    };
+
+    /**
+     * Converts a sequence of native elements into a Java object array.
+     */
+    template <typename T, typename Iterator>
+    jobjectArray java_object_array(JNIEnv* env, Iterator first, jsize len)
+    {
+        using element_type = arg_type_t<boxed_t<T>>;
+
+        static const GlobalClassRef elementClass(env, LocalClassRef(env, "java/lang/Object"));
+        jobjectArray arr = env->NewObjectArray(len, elementClass.ref(), nullptr);
+        if (arr == nullptr) {
+            throw JavaException(env);
+        }
+        for (jsize k = 0; k < len; ++k, ++first) {
+            LocalObjectRef element(env, element_type::java_value(env, *first));
+            env->SetObjectArrayElement(arr, k, element.ref());
+        }
+        return arr;
+    }
+
+    /**
+     * Supplies elements from a native iterator range.
+     *
+     * Random-access ranges are sized and can be split, which allows Java to process them in parallel.
+     */
+    template <typename Iterator>
+    struct RangeStreamSource : StreamSource
+    {
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+
+        constexpr static bool is_random_access = std::is_base_of_v<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<Iterator>::iterator_category
+        >;
+
+        RangeStreamSource(std::shared_ptr<const void> owner, Iterator first, Iterator last)
+            : _owner(std::move(owner))
+            , _first(first)
+            , _last(last)
+        {}
+
+        jobjectArray fetch(JNIEnv* env, jint count) override
+        {
+            if (_first == _last) {
+                return nullptr;
+            }
+
+            Iterator batch_end = _first;
+            jsize len = 0;
+            if constexpr (is_random_access) {
+                len = static_cast<jsize>(std::min<std::ptrdiff_t>(count, _last - _first));
+                batch_end += len;
+            } else {
+                for (; batch_end != _last && len < count; ++batch_end, ++len) {}
+            }
+
+            jobjectArray arr = java_object_array<value_type>(env, _first, len);
+            _first = batch_end;
+            return arr;
+        }
+
+        StreamSource* split() override
+        {
+            if constexpr (is_random_access) {
+                auto half = (_last - _first) / 2;
+                if (half == 0) {
+                    return nullptr;
+                }
+
+                // an ordered spliterator must hand over a prefix of its elements
+                Iterator mid = _first + half;
+                auto prefix = new RangeStreamSource(_owner, _first, mid);
+                _first = mid;
+                return prefix;
+            } else {
+                return nullptr;
+            }
+        }
+
+        jlong remaining() const override
+        {
+            if constexpr (is_random_access) {
+                return static_cast<jlong>(_last - _first);
+            } else {
+                return std::numeric_limits<jlong>::max();
+            }
+        }
+
+        jint characteristics() const override
+        {
+            if constexpr (is_random_access) {
+                return ordered | sized | subsized;
+            } else {
+                return ordered;
+            }
+        }
+
+    private:
+        /** Keeps the container that backs the iterators alive, if the range owns its elements. */
+        std::shared_ptr<const void> _owner;
+        Iterator _first;
+        Iterator _last;
+    };
+
+    /**
+     * Supplies elements from a native generator function that returns an empty optional when exhausted.
+     */
+    template <typename T>
+    struct GeneratorStreamSource : StreamSource
+    {
+        GeneratorStreamSource(std::function<std::optional<T>()>&& generator)
+            : _generator(std::move(generator))
+        {}
+
+        jobjectArray fetch(JNIEnv* env, jint count) override
+        {
+            if (_exhausted) {
+                return nullptr;
+            }
+
+            // generate elements in native code first to learn the exact size of the batch
+            _batch.clear();
+            while (static_cast<jint>(_batch.size()) < count) {
+                std::optional<T> item = _generator();
+                if (!item.has_value()) {
+                    _exhausted = true;
+                    break;
+                }
+                _batch.push_back(std::move(item.value()));
+            }
+
+            if (_batch.empty()) {
+                return nullptr;
+            }
+            return java_object_array<T>(env, _batch.begin(), static_cast<jsize>(_batch.size()));
+        }
+
+        StreamSource* split() override
+        {
+            return nullptr;
+        }
+
+        jlong remaining() const override
+        {
+            return _exhausted ? 0 : std::numeric_limits<jlong>::max();
+        }
+
+        jint characteristics() const override
+        {
+            return ordered;
+        }
+
+    private:
+        std::function<std::optional<T>()> _generator;
+        std::vector<T> _batch;
+        bool _exhausted = false;
+    };
+
+    /**
+     * A sequence of native elements that is consumed lazily in Java as a `java.util.stream.Stream`.
+     *
+     * Use `make_stream` or `generate_stream` to construct an instance. The batch size must be positive, and must fit
+     * into a Java `int`.
+     */
+    template <typename T>
+    struct stream
+    {
+        stream(std::unique_ptr<StreamSource>&& source, std::size_t batch_size)
+            : source(std::move(source))
+            , batch_size(batch_size)
+        {
+            if (batch_size < 1 || batch_size > static_cast<std::size_t>(std::numeric_limits<jint>::max())) {
+                throw std::invalid_argument(msg() << "Stream batch size " << batch_size << " is not in the range 1 to " << std::numeric_limits<jint>::max());
+            }
+        }
+
+        std::unique_ptr<StreamSource> source;
+        std::size_t batch_size;
+    };
+
+    /**
+     * Creates a stream that takes ownership of a container.
+     */
+    template <typename Container>
+    stream<typename std::decay_t<Container>::value_type> make_stream(Container&& container, std::size_t batch_size = stream_batch_size)
+    {
+        using container_type = std::decay_t<Container>;
+        using iterator_type = typename container_type::const_iterator;
+
+        auto owner = std::make_shared<const container_type>(std::forward<Container>(container));
+        auto source = std::make_unique<RangeStreamSource<iterator_type>>(owner, owner->begin(), owner->end());
+        return stream<typename container_type::value_type>(std::move(source), batch_size);
+    }
+
+    /**
+     * Creates a stream over an iterator range.
+     * The caller is responsible for keeping the underlying elements alive until Java has consumed the stream.
+     */
+    template <typename Iterator>
+    stream<typename std::iterator_traits<Iterator>::value_type> make_stream(Iterator first, Iterator last, std::size_t batch_size = stream_batch_size)
+    {
+        auto source = std::make_unique<RangeStreamSource<Iterator>>(nullptr, first, last);
+        return stream<typename std::iterator_traits<Iterator>::value_type>(std::move(source), batch_size);
+    }
+
+    /**
+     * Creates a stream from a generator function that returns an empty optional when no more elements are available.
+     */
+    template <typename Generator>
+    auto generate_stream(Generator&& generator, std::size_t batch_size = stream_batch_size)
+    {
+        using value_type = typename std::invoke_result_t<Generator>::value_type;
+
+        auto source = std::make_unique<GeneratorStreamSource<value_type>>(std::function<std::optional<value_type>()>(std::forward<Generator>(generator)));
+        return stream<value_type>(std::move(source), batch_size);
+    }
+
+    /**
+     * Native functions bound to the Java class `NativeSpliterator`.
+     */
+    struct StreamHandler
+    {
+        static jobjectArray fetch(JNIEnv* env, jclass, jlong ptr, jint count)
+        {
+            ReleaseQueue::drain(env);
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(fetch));
+            try {
+                return reinterpret_cast<StreamSource*>(ptr)->fetch(env, count);
+            } catch (JavaException& ex) {
+                env->Throw(ex.innerException());
+                return nullptr;
+            } catch (std::exception& ex) {
+                exception_handler(env, ex);
+                return nullptr;
+            }
+        }
+
+        static jlong split(JNIEnv* env, jclass, jlong ptr)
+        {
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(split));
+            try {
+                return reinterpret_cast<jlong>(reinterpret_cast<StreamSource*>(ptr)->split());
+            } catch (JavaException& ex) {
+                env->Throw(ex.innerException());
+                return 0;
+            } catch (std::exception& ex) {
+                exception_handler(env, ex);
+                return 0;
+            }
+        }
+
+        static jlong remaining(JNIEnv* env, jclass, jlong ptr)
+        {
+            env = accounted(env);
+            JNIAccounting::binding_scope accounting(reinterpret_cast<const void*>(remaining));
+            try {
+                return reinterpret_cast<StreamSource*>(ptr)->remaining();
+            } catch (JavaException& ex) {
+                env->Throw(ex.innerException());
+                return 0;
+            } catch (std::exception& ex) {
+                exception_handler(env, ex);
+                return 0;
+            }
+        }
+    };
+
+    /**
+     * Converts a native stream into a Java sequential `Stream` backed by a `NativeSpliterator`.
+     */
+    template <typename T>
+    struct JavaStreamType
+    {
+        using native_type = stream<T>;
+        using java_type = jobject;
+
+        constexpr static std::string_view class_name = "java.util.stream.Stream";
+        constexpr static std::string_view java_name = GenericTraits<class_name, boxed_t<T>>::java_name;
+        constexpr static std::string_view sig = "Ljava/util/stream/Stream;";
+        constexpr static std::string_view native_class_path = "hu/info/hunyadi/javabind/NativeSpliterator";
+
+        static java_type java_value(JNIEnv* env, native_type&& nativeStream)
+        {
+            LocalClassRef spliteratorClass(env, native_class_path);
+            Method constructor = spliteratorClass.getMethod("<init>", "(JII)V");
+            LocalClassRef streamSupportClass(env, "java/util/stream/StreamSupport");
+            StaticMethod streamFunc = streamSupportClass.getStaticMethod("stream", "(Ljava/util/Spliterator;Z)Ljava/util/stream/Stream;");
+
+            // ownership of the native source passes to the Java object
+            StreamSource* ptr = nativeStream.source.get();
+            LocalObjectRef spliterator(env, env->NewObject(
+                spliteratorClass.ref(),
+                constructor.ref(),
+                reinterpret_cast<jlong>(ptr),
+                static_cast<jint>(nativeStream.batch_size),
+                ptr->characteristics()
+            ));
+            if (spliterator.ref() == nullptr) {
+                throw JavaException(env);
+            }
+            nativeStream.source.release();
+
+            jobject javaStream = env->CallStaticObjectMethod(streamSupportClass.ref(), streamFunc.ref(), spliterator.ref(), JNI_FALSE);
+            if (javaStream == nullptr) {
+                throw JavaException(env);
+            }
+            return javaStream;
+        }
+    };
+
+    template <typename T> struct ArgType<stream<T>> { using type = JavaStreamType<T>; };
+}
@@ -0,0 +1,269 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+#pragma once
+#include <jni.h>
+
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#endif
+
+namespace javabind
+{
+#if defined(JAVABIND_LOCAL_REF_TRACKING)
+    /**
+     * Tracks local references created with JNI functions on the current thread.
+     *
+     * Tracking intercepts calls through the `JNIEnv` that javabind uses (see `JNIAccounting`). Any JNI function that
+     * returns a local reference adds it to the references alive on the thread, and `DeleteLocalRef` removes it again.
+     * `PopLocalFrame` removes all references created since the matching `PushLocalFrame`. References that the JVM has
+     * passed to the native function, and references obtained with another environment, are not tracked.
+     *
+     * Each call to a native function binding opens a frame. When the call returns, the tracker records the largest
+     * number of local references that were alive at the same time in the frame (the high-water mark), and the number
+     * of references still alive, which have leaked out of the frame. The reference that the binding returns to Java,
+     * or the exception that it throws, is handed over to the caller, and is not a leak. Leaks are reported by
+     * `NativeStats.localRefs()` rather than printed, since the frame closes when JNI calls may no longer be made.
+     */
+    class LocalRefTracker
+    {
+    public:
+        struct Record
+        {
+            std::uint64_t calls = 0;
+            /** Largest number of local references alive at the same time in a single call. */
+            std::size_t peak = 0;
+            /** Total number of local references alive on return, over all calls. */
+            std::uint64_t leaked = 0;
+        };
+
+        /**
+         * A native frame that spans a single call to a native function binding.
+         *
+         * @param binding The entry point of the native function binding.
+         */
+        class frame_scope
+        {
+        public:
+            explicit frame_scope(const void* binding)
+                : _binding(binding)
+                , _base(_refs.size())
+                , _outer_floor(_floor)
+                , _outer_peak(_peak)
+            {
+                _floor = _frames.size();
+                _peak = _base;
+                ++_depth;
+            }
+
+            frame_scope(const frame_scope&) = delete;
+            frame_scope& operator=(const frame_scope&) = delete;
+
+            ~frame_scope()
+            {
+                record(_binding, _peak - _base, _refs.size() - _base);
+
+                // the JVM frees all local references of the native frame on return
+                _refs.resize(_base);
+                _frames.resize(_floor);
+                _floor = _outer_floor;
+                _peak = std::max(_outer_peak, _peak);
+                --_depth;
+            }
+
+            /**
+             * Marks a local reference as passed to the caller, e.g. as the return value or as a thrown exception.
+             */
+            template <typename T>
+            T handover(T value)
+            {
+                if constexpr (std::is_convertible_v<T, jobject>) {
+                    release(value);
+                }
+                return value;
+            }
+
+        private:
+            const void* _binding;
+            std::size_t _base;
+            std::size_t _outer_floor;
+            std::size_t _outer_peak;
+        };
+
+        /**
+         * Registers a local reference that a JNI function has returned.
+         */
+        static void acquire(jobject ref)
+        {
+            if (_depth == 0 || ref == nullptr) {
+                return;
+            }
+            _refs.push_back(ref);
+            _peak = std::max(_peak, _refs.size());
+        }
+
+        /**
+         * Unregisters a local reference passed to `DeleteLocalRef`. References not created in a frame are ignored.
+         */
+        static void release(jobject ref)
+        {
+            if (_depth == 0 || ref == nullptr) {
+                return;
+            }
+            auto it = std::find(_refs.rbegin(), _refs.rend(), ref);
+            if (it == _refs.rend()) {
+                return;
+            }
+            std::size_t index = static_cast<std::size_t>(std::distance(it, _refs.rend())) - 1;
+            _refs.erase(_refs.begin() + static_cast<std::ptrdiff_t>(index));
+            for (auto&& start : _frames) {
+                if (start > index) {
+                    --start;
+                }
+            }
+        }
+
+        /**
+         * Opens a local reference frame after a successful call to `PushLocalFrame`.
+         */
+        static void push_frame()
+        {
+            if (_depth == 0) {
+                return;
+            }
+            _frames.push_back(_refs.size());
+        }
+
+        /**
+         * Closes the innermost local reference frame on a call to `PopLocalFrame`.
+         */
+        static void pop_frame()
+        {
+            if (_depth == 0 || _frames.size() <= _floor) {
+                return;
+            }
+            _refs.resize(_frames.back());
+            _frames.pop_back();
+        }
+
+        /**
+         * Number of tracked local references alive on the current thread.
+         */
+        static std::size_t live()
+        {
+            return _refs.size();
+        }
+
+        /**
+         * Associates a human-readable name with the entry point of a native function binding.
+         */
+        static void name(const void* binding, std::string name)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _names[binding] = std::move(name);
+        }
+
+        /**
+         * Returns what has been recorded for a native function binding.
+         *
+         * @param binding Name of the binding as registered with `name`, e.g. `hu.info.hunyadi.test.StaticSample.pass_int`.
+         */
+        static Record record_of(std::string_view binding)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto&& [key, value] : _records) {
+                if (name_of(key) == binding) {
+                    return value;
+                }
+            }
+            return Record();
+        }
+
+        /**
+         * Writes the high-water mark and the number of leaked references, one line per binding that has been called.
+         */
+        static void report(std::ostream& os)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto&& [key, value] : _records) {
+                os << name_of(key) << ": calls=" << value.calls << " peak=" << value.peak << " leaked=" << value.leaked << "\n";
+            }
+        }
+
+        static void reset()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _records.clear();
+        }
+
+    private:
+        static void record(const void* binding, std::size_t peak, std::size_t leaked)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Record& value = _records[binding];
+            value.calls += 1;
+            value.peak = std::max(value.peak, peak);
+            value.leaked += leaked;
+        }
+
+        /** Must be called with the mutex held. */
+        static std::string_view name_of(const void* binding)
+        {
+            auto it = _names.find(binding);
+            if (it == _names.end()) {
+                return "(unknown)";
+            }
+            return it->second;
+        }
+
+        inline static std::mutex _mutex;
+        inline static std::map<const void*, Record> _records;
+        inline static std::map<const void*, std::string> _names;
+        /** Local references alive on the current thread, in order of creation. */
+        inline static thread_local std::vector<jobject> _refs;
+        /** Index into `_refs` where each frame opened with `PushLocalFrame` starts. */
+        inline static thread_local std::vector<std::size_t> _frames;
+        /** Number of frames in `_frames` opened before the innermost native function binding was called. */
+        inline static thread_local std::size_t _floor = 0;
+        /** Number of native function binding calls in progress on the current thread. */
+        inline static thread_local std::size_t _depth = 0;
+        inline static thread_local std::size_t _peak = 0;
+    };
+#else
+    /**
+     * Placeholder for local reference tracking when instrumentation is disabled, optimized away entirely.
+     */
+    struct LocalRefTracker
+    {
+        struct frame_scope
+        {
+            explicit frame_scope(const void*)
+            {}
+
+            template <typename T>
+            T handover(T value)
+            {
+                return value;
+            }
+        };
+    };
+#endif
+}
@@ -46,4 +46,11 @@ namespace javabind
 
     template <typename Sig>
     using args_t = typename args<Sig>::type;
+
+    /**
+     * True if a native parameter type binds the JNI environment or a local reference of the native call that received
+     * it, and is thus invalid after the call returns or on another thread.
+     */
+    template <typename T>
+    struct is_call_scoped : std::false_type {};
 }
@@ -9,6 +9,8 @@
  */
 
 #pragma once
+#include <jni.h>
+#include <type_traits>
 
 namespace javabind
 {
@@ -32,4 +34,26 @@ namespace javabind
 
     template <typename T>
     using arg_type_t = typename ArgType<std::remove_cv_t<std::remove_reference_t<T>>>::type;
+
+    /**
+     * Number of local references a conversion holds at the same time in the frame of the caller, including the result.
+     *
+     * Types whose conversion creates temporary local references (e.g. a class reference) declare a static member
+     * `local_capacity`. Types that convert nested values (e.g. collections) push a frame of their own, and need only
+     * a single slot for the result in the frame of the caller.
+     */
+    template <typename T, typename = void>
+    struct local_capacity
+    {
+        constexpr static jint value = 1;
+    };
+
+    template <typename T>
+    struct local_capacity<T, std::void_t<decltype(T::local_capacity)>>
+    {
+        constexpr static jint value = T::local_capacity;
+    };
+
+    template <typename T>
+    constexpr jint local_capacity_v = local_capacity<arg_type_t<T>>::value;
 }
@@ -11,6 +11,7 @@
 #pragma once
 #include "local.hpp"
 #include <string_view>
+#include <utility>
 
 namespace javabind
 {
@@ -32,9 +33,18 @@ namespace javabind
 
         wrapped_string_view(const wrapped_string_view&) = delete;
 
+        /** Transfers the obligation to release the string to a new object. */
+        wrapped_string_view(wrapped_string_view&& other) noexcept
+            : _env(std::exchange(other._env, nullptr))
+            , _str(other._str)
+            , _view(other._view)
+        {}
+
         ~wrapped_string_view()
         {
-            _env->ReleaseStringUTFChars(_str, _view.data());
+            if (_env != nullptr) {
+                _env->ReleaseStringUTFChars(_str, _view.data());
+            }
         }
 
         std::string_view view() const
@@ -73,9 +83,18 @@ namespace javabind
 
         wrapped_u16string_view(const wrapped_u16string_view&) = delete;
 
+        /** Transfers the obligation to release the string to a new object. */
+        wrapped_u16string_view(wrapped_u16string_view&& other) noexcept
+            : _env(std::exchange(other._env, nullptr))
+            , _str(other._str)
+            , _view(other._view)
+        {}
+
         ~wrapped_u16string_view()
         {
-            _env->ReleaseStringCritical(_str, reinterpret_cast<const jchar*>(_view.data()));
+            if (_env != nullptr) {
+                _env->ReleaseStringCritical(_str, reinterpret_cast<const jchar*>(_view.data()));
+            }
         }
 
         std::u16string_view view() const
@@ -113,9 +132,18 @@ namespace javabind
 
         wrapped_array_view(const wrapped_array_view&) = delete;
 
+        /** Transfers the obligation to release the array to a new object. */
+        wrapped_array_view(wrapped_array_view&& other) noexcept
+            : _env(std::exchange(other._env, nullptr))
+            , _arr(other._arr)
+            , _view(other._view)
+        {}
+
         ~wrapped_array_view()
         {
-            _env->ReleasePrimitiveArrayCritical(_arr, const_cast<T*>(_view.data()), JNI_ABORT);
+            if (_env != nullptr) {
+                _env->ReleasePrimitiveArrayCritical(_arr, const_cast<T*>(_view.data()), JNI_ABORT);
+            }
         }
 
         std::basic_string_view<T> view() const
@@ -0,0 +1,555 @@
+package hu.info.hunyadi.benchmark;
+
+import java.io.IOException;
+import java.io.PrintWriter;
+import java.lang.management.ManagementFactory;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.time.Duration;
+import java.time.Instant;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+import java.util.Set;
+import java.util.TreeMap;
+import java.util.TreeSet;
+import java.util.function.Function;
+import java.util.function.IntConsumer;
+import java.util.function.IntPredicate;
+import java.util.function.ToIntFunction;
+
+import hu.info.hunyadi.javabind.NativeStats;
+
+/**
+ * Measures the cost of a native call for each type mapped by javabind, in each direction.
+ *
+ * Each benchmark is named {@code type[size]/direction}, where direction is one of
+ * <ul>
+ * <li>{@code argument}: a Java value is converted into a native value,</li>
+ * <li>{@code view}: a Java string or array is accessed in place as a native view,</li>
+ * <li>{@code result}: a native value is converted into a Java value,</li>
+ * <li>{@code upcall}: a Java functional interface is passed to and invoked once from native code,</li>
+ * <li>{@code native}: a native function object returned to Java is invoked from Java.</li>
+ * </ul>
+ *
+ * For each benchmark, the time per call, the bytes allocated on the Java heap per call (if the Java VM can measure
+ * it), and the number of native heap allocations per call are reported.
+ *
+ * With {@code --jni-calls}, the number of calls to each JNI function per call is reported instead, which requires a
+ * benchmark library compiled with {@code JAVABIND_JNI_ACCOUNTING} (selected with {@code --library}). Unlike timings,
+ * these numbers are deterministic.
+ *
+ * Usage: {@code Benchmark [--filter text] [--time milliseconds] [--library name] [--jni-calls] [--output file.json]}
+ */
+public class Benchmark {
+    /**
+     * An operation to measure, which returns a value derived from its result to keep the call from being optimized
+     * away.
+     */
+    @FunctionalInterface
+    interface Operation {
+        long run();
+    }
+
+    record Case(String name, Runnable setup, Operation operation) {
+    }
+
+    /**
+     * Measurements of a single benchmark, with {@code NaN} for quantities that have not been measured.
+     *
+     * @param jniCallsPerCall Number of calls to each JNI function per call, or {@code null} if not measured.
+     */
+    record Result(String name, long iterations, double nanosPerCall, double javaBytesPerCall,
+            double nativeAllocationsPerCall, Map<String, Double> jniCallsPerCall) {
+    }
+
+    private static final int ROUNDS = 5;
+    private static final int JNI_CALL_WARMUP = 1000;
+    private static final int JNI_CALL_REPETITIONS = 64;
+    private static final int[] ARRAY_SIZES = { 16, 1024, 65536 };
+    private static final int[] OBJECT_SIZES = { 16, 1024 };
+
+    private static long sink = 0;
+
+    private final List<Case> cases = new ArrayList<>();
+
+    public static void main(String[] args) throws IOException {
+        String filter = "";
+        long timeMillis = 1000;
+        Path output = null;
+        String library = "javabind_benchmark";
+        boolean jniCalls = false;
+        for (int i = 0; i < args.length; ++i) {
+            switch (args[i]) {
+                case "--filter" -> filter = args[++i];
+                case "--time" -> timeMillis = Long.parseLong(args[++i]);
+                case "--output" -> output = Path.of(args[++i]);
+                case "--library" -> library = args[++i];
+                case "--jni-calls" -> jniCalls = true;
+                default -> throw new IllegalArgumentException("unrecognized argument: " + args[i]);
+            }
+        }
+
+        System.loadLibrary(library);
+
+        Benchmark benchmark = new Benchmark();
+        benchmark.register();
+
+        List<Result> results = new ArrayList<>();
+        if (jniCalls) {
+            System.out.println(String.format(Locale.ROOT, "%-44s %s", "benchmark", "JNI calls/call"));
+        } else {
+            System.out.println(String.format(Locale.ROOT, "%-44s %12s %14s %14s", "benchmark", "ns/call",
+                    "bytes/call", "allocs/call"));
+        }
+        for (Case c : benchmark.cases) {
+            if (!c.name().contains(filter)) {
+                continue;
+            }
+            if (jniCalls) {
+                Result result = measureJniCalls(c);
+                results.add(result);
+                StringBuilder calls = new StringBuilder();
+                result.jniCallsPerCall().forEach((function, count) -> calls.append(' ').append(function).append('=')
+                        .append(String.format(Locale.ROOT, "%.2f", count)));
+                System.out.println(String.format(Locale.ROOT, "%-44s%s", result.name(), calls));
+            } else {
+                Result result = measure(c, timeMillis * 1_000_000);
+                results.add(result);
+                System.out.println(String.format(Locale.ROOT, "%-44s %12.1f %14s %14.2f", result.name(),
+                        result.nanosPerCall(),
+                        Double.isNaN(result.javaBytesPerCall()) ? "-"
+                                : String.format(Locale.ROOT, "%.1f", result.javaBytesPerCall()),
+                        result.nativeAllocationsPerCall()));
+            }
+        }
+
+        if (output != null) {
+            writeJson(output, results);
+        }
+        if (sink == 42) {
+            System.out.println();
+        }
+    }
+
+    private void add(String name, Runnable setup, Operation operation) {
+        cases.add(new Case(name, setup, operation));
+    }
+
+    private void add(String name, Operation operation) {
+        add(name, () -> {
+        }, operation);
+    }
+
+    private void register() {
+        // primitive types
+        add("boolean/argument", () -> {
+            Marshalling.accept_boolean(true);
+            return 1;
+        });
+        add("boolean/result", () -> Marshalling.result_boolean() ? 1 : 0);
+        add("byte/argument", () -> {
+            Marshalling.accept_byte((byte) 1);
+            return 1;
+        });
+        add("byte/result", () -> Marshalling.result_byte());
+        add("char/argument", () -> {
+            Marshalling.accept_char('a');
+            return 1;
+        });
+        add("char/result", () -> Marshalling.result_char());
+        add("short/argument", () -> {
+            Marshalling.accept_short((short) 1);
+            return 1;
+        });
+        add("short/result", () -> Marshalling.result_short());
+        add("int/argument", () -> {
+            Marshalling.accept_int(1);
+            return 1;
+        });
+        add("int/result", () -> Marshalling.result_int());
+        add("long/argument", () -> {
+            Marshalling.accept_long(1L);
+            return 1;
+        });
+        add("long/result", () -> Marshalling.result_long());
+        add("float/argument", () -> {
+            Marshalling.accept_float(1.0f);
+            return 1;
+        });
+        add("float/result", () -> (long) Marshalling.result_float());
+        add("double/argument", () -> {
+            Marshalling.accept_double(1.0);
+            return 1;
+        });
+        add("double/result", () -> (long) Marshalling.result_double());
+
+        // boxed types
+        Integer boxedInteger = 1024;
+        Double boxedDouble = 1.5;
+        add("boxed_integer/argument", () -> {
+            Marshalling.accept_boxed_integer(boxedInteger);
+            return 1;
+        });
+        add("boxed_integer/result", () -> Marshalling.accept_boxed_integer(boxedInteger),
+                () -> Marshalling.result_boxed_integer().intValue());
+        add("boxed_double/argument", () -> {
+            Marshalling.accept_boxed_double(boxedDouble);
+            return 1;
+        });
+        add("boxed_double/result", () -> Marshalling.accept_boxed_double(boxedDouble),
+                () -> (long) Marshalling.result_boxed_double().doubleValue());
+
+        // strings of ASCII characters, characters in the Basic Multilingual Plane, and supplementary characters
+        for (int size : ARRAY_SIZES) {
+            registerString("string.ascii[" + size + "]", asciiString(size));
+            registerString("string.bmp[" + size + "]", bmpString(size));
+            registerString("string.supplementary[" + size + "]", supplementaryString(size));
+        }
+
+        // primitive arrays
+        for (int size : ARRAY_SIZES) {
+            byte[] bytes = new byte[size];
+            int[] ints = new int[size];
+            double[] doubles = new double[size];
+            for (int i = 0; i < size; ++i) {
+                bytes[i] = (byte) i;
+                ints[i] = i;
+                doubles[i] = i;
+            }
+            String suffix = "[" + size + "]";
+            add("byte_array" + suffix + "/argument", () -> {
+                Marshalling.accept_byte_array(bytes);
+                return 1;
+            });
+            add("byte_array" + suffix + "/view", () -> Marshalling.accept_byte_array_view(bytes));
+            add("byte_array" + suffix + "/result", () -> Marshalling.accept_byte_array(bytes),
+                    () -> Marshalling.result_byte_array().length);
+            add("int_array" + suffix + "/argument", () -> {
+                Marshalling.accept_int_array(ints);
+                return 1;
+            });
+            add("int_array" + suffix + "/view", () -> Marshalling.accept_int_array_view(ints));
+            add("int_array" + suffix + "/result", () -> Marshalling.accept_int_array(ints),
+                    () -> Marshalling.result_int_array().length);
+            add("double_array" + suffix + "/argument", () -> {
+                Marshalling.accept_double_array(doubles);
+                return 1;
+            });
+            add("double_array" + suffix + "/view", () -> Marshalling.accept_double_array_view(doubles));
+            add("double_array" + suffix + "/result", () -> Marshalling.accept_double_array(doubles),
+                    () -> Marshalling.result_double_array().length);
+        }
+
+        // object arrays and collections
+        for (int size : OBJECT_SIZES) {
+            String[] strings = new String[size];
+            Point[] points = new Point[size];
+            Map<String, Integer> map = new HashMap<>();
+            for (int i = 0; i < size; ++i) {
+                strings[i] = "key" + i;
+                points[i] = new Point(i, -i);
+                map.put(strings[i], i);
+            }
+            List<Point> list = Arrays.asList(points);
+            Set<String> hashSet = new HashSet<>(Arrays.asList(strings));
+            Set<String> treeSet = new TreeSet<>(hashSet);
+            Map<String, Integer> treeMap = new TreeMap<>(map);
+
+            String suffix = "[" + size + "]";
+            add("string_array" + suffix + "/argument", () -> {
+                Marshalling.accept_string_array(strings);
+                return 1;
+            });
+            add("string_array" + suffix + "/result", () -> Marshalling.accept_string_array(strings),
+                    () -> Marshalling.result_string_array().length);
+            add("record_array" + suffix + "/argument", () -> {
+                Marshalling.accept_point_array(points);
+                return 1;
+            });
+            add("record_array" + suffix + "/result", () -> Marshalling.accept_point_array(points),
+                    () -> Marshalling.result_point_array().length);
+            add("list" + suffix + "/argument", () -> {
+                Marshalling.accept_list(list);
+                return 1;
+            });
+            add("list" + suffix + "/result", () -> Marshalling.accept_list(list),
+                    () -> Marshalling.result_list().size());
+            add("ordered_set" + suffix + "/argument", () -> {
+                Marshalling.accept_ordered_set(treeSet);
+                return 1;
+            });
+            add("ordered_set" + suffix + "/result", () -> Marshalling.accept_ordered_set(treeSet),
+                    () -> Marshalling.result_ordered_set().size());
+            add("unordered_set" + suffix + "/argument", () -> {
+                Marshalling.accept_unordered_set(hashSet);
+                return 1;
+            });
+            add("unordered_set" + suffix + "/result", () -> Marshalling.accept_unordered_set(hashSet),
+                    () -> Marshalling.result_unordered_set().size());
+            add("ordered_map" + suffix + "/argument", () -> {
+                Marshalling.accept_ordered_map(treeMap);
+                return 1;
+            });
+            add("ordered_map" + suffix + "/result", () -> Marshalling.accept_ordered_map(treeMap),
+                    () -> Marshalling.result_ordered_map().size());
+            add("unordered_map" + suffix + "/argument", () -> {
+                Marshalling.accept_unordered_map(map);
+                return 1;
+            });
+            add("unordered_map" + suffix + "/result", () -> Marshalling.accept_unordered_map(map),
+                    () -> Marshalling.result_unordered_map().size());
+            add("stream" + suffix + "/result", () -> Marshalling.get_int_stream(size).count());
+        }
+
+        // records, enumerations and date and time types
+        Point point = new Point(1.0, 2.0);
+        Duration duration = Duration.ofSeconds(3600, 1);
+        Instant instant = Instant.ofEpochSecond(1700000000L, 123456789);
+        add("record/argument", () -> {
+            Marshalling.accept_point(point);
+            return 1;
+        });
+        add("record/result", () -> Marshalling.accept_point(point), () -> (long) Marshalling.result_point().x());
+        add("enum/argument", () -> {
+            Marshalling.accept_color(Color.Green);
+            return 1;
+        });
+        add("enum/result", () -> Marshalling.accept_color(Color.Green), () -> Marshalling.result_color().ordinal());
+        add("duration/argument", () -> {
+            Marshalling.accept_duration(duration);
+            return 1;
+        });
+        add("duration/result", () -> Marshalling.accept_duration(duration),
+                () -> Marshalling.result_duration().getNano());
+        add("instant/argument", () -> {
+            Marshalling.accept_instant(instant);
+            return 1;
+        });
+        add("instant/result", () -> Marshalling.accept_instant(instant), () -> Marshalling.result_instant().getNano());
+
+        // optional values
+        add("optional_int/argument", () -> {
+            Marshalling.accept_optional_int(boxedInteger);
+            return 1;
+        });
+        add("optional_int/result", () -> Marshalling.accept_optional_int(boxedInteger),
+                () -> Marshalling.result_optional_int().intValue());
+        add("optional_int.empty/argument", () -> {
+            Marshalling.accept_optional_int(null);
+            return 1;
+        });
+        add("optional_string/argument", () -> {
+            Marshalling.accept_optional_string("optional");
+            return 1;
+        });
+        add("optional_string/result", () -> Marshalling.accept_optional_string("optional"),
+                () -> Marshalling.result_optional_string().length());
+
+        // functional interfaces
+        IntPredicate intPredicate = value -> value > 0;
+        IntConsumer intConsumer = value -> sink += value;
+        Function<String, String> function = value -> value;
+        ToIntFunction<String> toIntFunction = String::length;
+        add("int_predicate/upcall", () -> Marshalling.invoke_int_predicate(intPredicate, 1) ? 1 : 0);
+        add("int_consumer/upcall", () -> {
+            Marshalling.invoke_int_consumer(intConsumer, 1);
+            return 1;
+        });
+        add("function/upcall", () -> Marshalling.invoke_function(function, "value").length());
+        add("to_int_function/upcall", () -> Marshalling.invoke_to_int_function(toIntFunction, "value"));
+        add("int_predicate/result", () -> Marshalling.get_int_predicate().hashCode());
+        add("function/result", () -> Marshalling.get_function().hashCode());
+
+        IntPredicate nativeIntPredicate = Marshalling.get_int_predicate();
+        IntConsumer nativeIntConsumer = Marshalling.get_int_consumer();
+        Function<String, String> nativeFunction = Marshalling.get_function();
+        ToIntFunction<String> nativeToIntFunction = Marshalling.get_to_int_function();
+        add("int_predicate/native", () -> nativeIntPredicate.test(2) ? 1 : 0);
+        add("int_consumer/native", () -> {
+            nativeIntConsumer.accept(1);
+            return 1;
+        });
+        add("function/native", () -> nativeFunction.apply("value").length());
+        add("to_int_function/native", () -> nativeToIntFunction.applyAsInt("value"));
+
+        // native objects
+        add("native_object/create_close", () -> {
+            try (Counter object = Counter.create()) {
+                return 1;
+            }
+        });
+        Counter counter = Counter.create();
+        add("native_object/member", () -> {
+            counter.add(1);
+            return 1;
+        });
+    }
+
+    private void registerString(String name, String value) {
+        add(name + "/argument", () -> {
+            Marshalling.accept_string(value);
+            return 1;
+        });
+        add(name + "/view", () -> Marshalling.accept_string_view(value));
+        add(name + "/utf16_view", () -> Marshalling.accept_u16string_view(value));
+        add(name + "/result", () -> Marshalling.accept_string(value), () -> Marshalling.result_string().length());
+    }
+
+    private static String asciiString(int length) {
+        StringBuilder builder = new StringBuilder(length);
+        for (int i = 0; i < length; ++i) {
+            builder.append((char) ('a' + i % 26));
+        }
+        return builder.toString();
+    }
+
+    private static String bmpString(int length) {
+        String alphabet = "\u00e1rv\u00edzt\u0171r\u0151 t\u00fck\u00f6rf\u00far\u00f3g\u00e9p \u03a9\u03bc\u03ad\u03b3\u03b1 \u65e5\u672c\u8a9e";
+        StringBuilder builder = new StringBuilder(length);
+        for (int i = 0; i < length; ++i) {
+            builder.append(alphabet.charAt(i % alphabet.length()));
+        }
+        return builder.toString();
+    }
+
+    /** A string of the given length in UTF-16 code units made up of surrogate pairs. */
+    private static String supplementaryString(int length) {
+        StringBuilder builder = new StringBuilder(length);
+        for (int i = 0; i < length / 2; ++i) {
+            builder.appendCodePoint(0x1F600 + i % 64);
+        }
+        return builder.toString();
+    }
+
+    /** Bytes allocated on the Java heap by the current thread, or -1 if the Java VM cannot measure it. */
+    @SuppressWarnings("deprecation")
+    private static long allocatedBytes() {
+        if (ManagementFactory.getThreadMXBean() instanceof com.sun.management.ThreadMXBean bean
+                && bean.isThreadAllocatedMemorySupported() && bean.isThreadAllocatedMemoryEnabled()) {
+            return bean.getThreadAllocatedBytes(Thread.currentThread().getId());
+        }
+        return -1;
+    }
+
+    /**
+     * Runs an operation repeatedly for the given time, in batches such that reading the clock has no effect on the
+     * measurement, after a warm-up period of the same length, and reports the median of several rounds.
+     */
+    private static Result measure(Case c, long timeNanos) {
+        Operation operation = c.operation();
+        c.setup().run();
+
+        long batch = 1;
+        while (batch < (1L << 30)) {
+            long start = System.nanoTime();
+            runBatch(operation, batch);
+            if (System.nanoTime() - start >= 1_000_000) {
+                break;
+            }
+            batch *= 2;
+        }
+
+        long warmupEnd = System.nanoTime() + timeNanos;
+        while (System.nanoTime() < warmupEnd) {
+            runBatch(operation, batch);
+        }
+
+        double[] nanosPerCall = new double[ROUNDS];
+        long iterations = 0;
+        long javaBytes = 0;
+        long nativeAllocations = 0;
+        for (int round = 0; round < ROUNDS; ++round) {
+            long bytesBefore = allocatedBytes();
+            long allocationsBefore = Marshalling.native_allocations();
+            long count = 0;
+            long start = System.nanoTime();
+            long elapsed;
+            do {
+                runBatch(operation, batch);
+                count += batch;
+                elapsed = System.nanoTime() - start;
+            } while (elapsed < timeNanos / ROUNDS);
+            nativeAllocations += Marshalling.native_allocations() - allocationsBefore;
+            long bytesAfter = allocatedBytes();
+            javaBytes = bytesBefore < 0 || javaBytes < 0 ? -1 : javaBytes + (bytesAfter - bytesBefore);
+            nanosPerCall[round] = (double) elapsed / count;
+            iterations += count;
+        }
+        Arrays.sort(nanosPerCall);
+
+        return new Result(c.name(), iterations, nanosPerCall[ROUNDS / 2],
+                javaBytes < 0 ? Double.NaN : (double) javaBytes / iterations, (double) nativeAllocations / iterations,
+                null);
+    }
+
+    /**
+     * Counts the JNI functions called by an operation, after a warm-up that populates caches of classes and methods.
+     */
+    private static Result measureJniCalls(Case c) {
+        Operation operation = c.operation();
+        c.setup().run();
+        runBatch(operation, JNI_CALL_WARMUP);
+        NativeStats.reset();
+        runBatch(operation, JNI_CALL_REPETITIONS);
+
+        // each line has the form "binding [type]: Function=count Function=count ..."
+        Map<String, Long> totals = new TreeMap<>();
+        for (String line : NativeStats.jniCalls().split("\n")) {
+            int index = line.indexOf(": ");
+            if (index < 0) {
+                continue;
+            }
+            for (String item : line.substring(index + 2).trim().split(" ")) {
+                int separator = item.indexOf('=');
+                if (separator < 0) {
+                    continue;
+                }
+                totals.merge(item.substring(0, separator), Long.parseLong(item.substring(separator + 1)), Long::sum);
+            }
+        }
+        Map<String, Double> calls = new TreeMap<>();
+        totals.forEach((function, count) -> calls.put(function, (double) count / JNI_CALL_REPETITIONS));
+        return new Result(c.name(), JNI_CALL_REPETITIONS, Double.NaN, Double.NaN, Double.NaN, calls);
+    }
+
+    private static void runBatch(Operation operation, long batch) {
+        long value = 0;
+        for (long i = 0; i < batch; ++i) {
+            value += operation.run();
+        }
+        sink += value;
+    }
+
+    private static String number(double value) {
+        return Double.isNaN(value) ? "null" : String.format(Locale.ROOT, "%.3f", value);
+    }
+
+    private static void writeJson(Path path, List<Result> results) throws IOException {
+        try (PrintWriter writer = new PrintWriter(Files.newBufferedWriter(path, StandardCharsets.UTF_8))) {
+            writer.println("{");
+            writer.println("  \"benchmarks\": [");
+            for (int i = 0; i < results.size(); ++i) {
+                Result result = results.get(i);
+                writer.print(String.format(Locale.ROOT,
+                        "    {\"name\": \"%s\", \"iterations\": %d, \"ns_per_call\": %s, \"java_bytes_per_call\": %s, \"native_allocations_per_call\": %s",
+                        result.name(), result.iterations(), number(result.nanosPerCall()),
+                        number(result.javaBytesPerCall()), number(result.nativeAllocationsPerCall())));
+                if (result.jniCallsPerCall() != null) {
+                    List<String> calls = new ArrayList<>();
+                    result.jniCallsPerCall().forEach(
+                            (function, count) -> calls.add("\"" + function + "\": " + number(count)));
+                    writer.print(", \"jni_calls_per_call\": {" + String.join(", ", calls) + "}");
+                }
+                writer.println(i + 1 < results.size() ? "}," : "}");
+            }
+            writer.println("  ]");
+            writer.println("}");
+        }
+    }
+}
@@ -0,0 +1,7 @@
+package hu.info.hunyadi.benchmark;
+
+public enum Color {
+    Red,
+    Green,
+    Blue
+}
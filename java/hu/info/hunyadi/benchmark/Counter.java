@@ -0,0 +1,13 @@
+package hu.info.hunyadi.benchmark;
+
+import hu.info.hunyadi.javabind.NativeObject;
+
+public class Counter extends NativeObject {
+    public static native Counter create();
+
+    public native void close();
+
+    public native void add(int value);
+
+    public native long value();
+}
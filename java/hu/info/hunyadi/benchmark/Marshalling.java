@@ -0,0 +1,159 @@
+package hu.info.hunyadi.benchmark;
+
+import java.time.Duration;
+import java.time.Instant;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.function.Function;
+import java.util.function.IntConsumer;
+import java.util.function.IntPredicate;
+import java.util.function.ToIntFunction;
+import java.util.stream.Stream;
+
+/**
+ * Native functions that do (almost) nothing, such that the time of a call is dominated by marshalling.
+ *
+ * Functions prefixed with {@code accept_} convert a Java value into a native value, and keep the last value received.
+ * Functions prefixed with {@code result_} convert the last value received back into a Java value.
+ */
+public class Marshalling {
+    /** Number of native heap allocations made by the extension module on the current thread. */
+    public static native long native_allocations();
+
+    public static native void accept_boolean(boolean value);
+
+    public static native boolean result_boolean();
+
+    public static native void accept_byte(byte value);
+
+    public static native byte result_byte();
+
+    public static native void accept_char(char value);
+
+    public static native char result_char();
+
+    public static native void accept_short(short value);
+
+    public static native short result_short();
+
+    public static native void accept_int(int value);
+
+    public static native int result_int();
+
+    public static native void accept_long(long value);
+
+    public static native long result_long();
+
+    public static native void accept_float(float value);
+
+    public static native float result_float();
+
+    public static native void accept_double(double value);
+
+    public static native double result_double();
+
+    public static native void accept_boxed_integer(Integer value);
+
+    public static native Integer result_boxed_integer();
+
+    public static native void accept_boxed_double(Double value);
+
+    public static native Double result_boxed_double();
+
+    public static native void accept_string(String value);
+
+    public static native String result_string();
+
+    public static native long accept_string_view(String value);
+
+    public static native long accept_u16string_view(String value);
+
+    public static native void accept_byte_array(byte[] values);
+
+    public static native byte[] result_byte_array();
+
+    public static native void accept_int_array(int[] values);
+
+    public static native int[] result_int_array();
+
+    public static native void accept_double_array(double[] values);
+
+    public static native double[] result_double_array();
+
+    public static native long accept_byte_array_view(byte[] values);
+
+    public static native long accept_int_array_view(int[] values);
+
+    public static native long accept_double_array_view(double[] values);
+
+    public static native void accept_string_array(String[] values);
+
+    public static native String[] result_string_array();
+
+    public static native void accept_point_array(Point[] values);
+
+    public static native Point[] result_point_array();
+
+    public static native void accept_point(Point value);
+
+    public static native Point result_point();
+
+    public static native void accept_color(Color value);
+
+    public static native Color result_color();
+
+    public static native void accept_duration(Duration value);
+
+    public static native Duration result_duration();
+
+    public static native void accept_instant(Instant value);
+
+    public static native Instant result_instant();
+
+    public static native void accept_list(List<Point> list);
+
+    public static native List<Point> result_list();
+
+    public static native void accept_ordered_set(Set<String> set);
+
+    public static native Set<String> result_ordered_set();
+
+    public static native void accept_unordered_set(Set<String> set);
+
+    public static native Set<String> result_unordered_set();
+
+    public static native void accept_ordered_map(Map<String, Integer> map);
+
+    public static native Map<String, Integer> result_ordered_map();
+
+    public static native void accept_unordered_map(Map<String, Integer> map);
+
+    public static native Map<String, Integer> result_unordered_map();
+
+    public static native void accept_optional_int(Integer value);
+
+    public static native Integer result_optional_int();
+
+    public static native void accept_optional_string(String value);
+
+    public static native String result_optional_string();
+
+    public static native Stream<Integer> get_int_stream(int count);
+
+    public static native boolean invoke_int_predicate(IntPredicate fn, int value);
+
+    public static native void invoke_int_consumer(IntConsumer fn, int value);
+
+    public static native String invoke_function(Function<String, String> fn, String value);
+
+    public static native int invoke_to_int_function(ToIntFunction<String> fn, String value);
+
+    public static native IntPredicate get_int_predicate();
+
+    public static native IntConsumer get_int_consumer();
+
+    public static native Function<String, String> get_function();
+
+    public static native ToIntFunction<String> get_to_int_function();
+}
@@ -0,0 +1,4 @@
+package hu.info.hunyadi.benchmark;
+
+public record Point(double x, double y) {
+}
@@ -0,0 +1,63 @@
+package hu.info.hunyadi.benchmark;
+
+import java.io.OutputStream;
+import java.io.PrintStream;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.function.Function;
+import java.util.function.IntConsumer;
+import java.util.function.IntPredicate;
+import java.util.function.ToIntFunction;
+
+/**
+ * Java objects that the embedded benchmark harness calls from C++.
+ */
+public class Upcalls {
+    public static Function<String, String> function() {
+        return value -> value;
+    }
+
+    public static IntPredicate intPredicate() {
+        return value -> value > 0;
+    }
+
+    public static IntConsumer intConsumer() {
+        return value -> {
+        };
+    }
+
+    public static ToIntFunction<String> toIntFunction() {
+        return String::length;
+    }
+
+    public static List<String> list(int size) {
+        List<String> list = new ArrayList<>(size);
+        for (int i = 0; i < size; ++i) {
+            list.add("item" + i);
+        }
+        return list;
+    }
+
+    public static Set<String> set(int size) {
+        return new HashSet<>(list(size));
+    }
+
+    public static Map<String, Integer> map(int size) {
+        Map<String, Integer> map = new HashMap<>();
+        for (int i = 0; i < size; ++i) {
+            map.put("key" + i, i);
+        }
+        return map;
+    }
+
+    /** Replaces the standard output with a stream that discards output, and returns the original stream. */
+    public static PrintStream discardOutput() {
+        PrintStream out = System.out;
+        System.setOut(new PrintStream(OutputStream.nullOutputStream()));
+        return out;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+package hu.info.hunyadi.javabind;
+
+import java.lang.reflect.Array;
+import java.util.Collection;
+import java.util.Map;
+import jdk.jfr.Category;
+import jdk.jfr.Description;
+import jdk.jfr.Event;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * Java Flight Recorder event of a call to a native function.
+ *
+ * Native functions bound with the option traced are invoked through a
+ * generated method that begins the event before the native call, and commits
+ * it when the call returns or raises an exception. When no recording is
+ * running or the event is disabled, the event is not committed, and argument
+ * sizes are not computed.
+ */
+@Name("hu.info.hunyadi.javabind.NativeCall")
+@Label("Native Call")
+@Category("javabind")
+@Description("Call from Java to a native function bound with javabind")
+public final class NativeCallEvent extends Event {
+    @Label("Binding")
+    @Description("Fully qualified name of the native function, in the form fully.qualified.Class.method")
+    public String binding;
+
+    @Label("Argument Size")
+    @Description("Total number of characters, elements and entries in string, array, collection and map arguments")
+    public long argumentSize;
+
+    /**
+     * Total size of arguments: the length of strings and arrays, and the
+     * number of elements in collections and maps. Other arguments have no
+     * size.
+     */
+    public static long sizeOf(Object... args) {
+        long size = 0;
+        for (Object arg : args) {
+            if (arg instanceof CharSequence) {
+                size += ((CharSequence) arg).length();
+            } else if (arg instanceof Collection) {
+                size += ((Collection<?>) arg).size();
+            } else if (arg instanceof Map) {
+                size += ((Map<?, ?>) arg).size();
+            } else if (arg != null && arg.getClass().isArray()) {
+                size += Array.getLength(arg);
+            }
+        }
+        return size;
+    }
+}
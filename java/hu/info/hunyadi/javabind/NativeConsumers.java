@@ -0,0 +1,32 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+package hu.info.hunyadi.javabind;
+
+import java.util.function.Consumer;
+
+/**
+ * Passes elements produced in native code to a consumer in batches, reducing
+ * the number of transitions when native code emits many elements.
+ */
+public final class NativeConsumers {
+    private NativeConsumers() {
+    }
+
+    /**
+     * Passes the first count elements of the array to the consumer in order.
+     */
+    @SuppressWarnings("unchecked")
+    static <T> void acceptAll(Consumer<? super T> consumer, Object[] items, int count) {
+        for (int i = 0; i < count; ++i) {
+            consumer.accept((T) items[i]);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+package hu.info.hunyadi.javabind;
+
+import java.util.Iterator;
+import java.util.Map;
+
+/**
+ * Copies elements of Java collections into arrays in batches, reducing the
+ * number of transitions when native code consumes a collection.
+ */
+public final class NativeIterators {
+    private NativeIterators() {
+    }
+
+    /**
+     * Moves the iterator forward by at most as many elements as the array can
+     * hold, storing elements in the array.
+     *
+     * @return The number of elements stored, less than the array length if the
+     *         iterator has been exhausted.
+     */
+    static int drain(Iterator<?> iterator, Object[] items) {
+        int count = 0;
+        while (count < items.length && iterator.hasNext()) {
+            items[count++] = iterator.next();
+        }
+        return count;
+    }
+
+    /**
+     * Moves the iterator forward by at most as many entries as the arrays can
+     * hold, storing keys and values in separate arrays.
+     *
+     * @return The number of entries stored, less than the array length if the
+     *         iterator has been exhausted.
+     */
+    static int drainEntries(Iterator<? extends Map.Entry<?, ?>> iterator, Object[] keys, Object[] values) {
+        int count = 0;
+        while (count < keys.length && iterator.hasNext()) {
+            Map.Entry<?, ?> entry = iterator.next();
+            keys[count] = entry.getKey();
+            values[count] = entry.getValue();
+            ++count;
+        }
+        return count;
+    }
+}
@@ -33,4 +33,35 @@ public abstract class NativeObject implements AutoCloseable {
      * Disposes of objects allocated in the native code execution context.
      */
     public abstract void close();
+
+    /** Index of the number of native objects created in the array returned by {@link #objectCounts(Class)}. */
+    public static final int CREATED = 0;
+    /** Index of the number of native objects disposed of. */
+    public static final int DESTROYED = 1;
+    /** Index of the number of native objects not yet disposed of. */
+    public static final int LIVE = 2;
+    /** Index of the estimated memory held by live native objects, in bytes. */
+    public static final int LIVE_BYTES = 3;
+
+    /**
+     * Number of native objects of a class, indexed by CREATED, DESTROYED, LIVE
+     * and LIVE_BYTES.
+     */
+    public static long[] objectCounts(Class<? extends NativeObject> cls) {
+        return objectCounts(cls.getName());
+    }
+
+    /**
+     * Number of native objects not yet disposed of for a class.
+     */
+    public static long liveObjects(Class<? extends NativeObject> cls) {
+        return objectCounts(cls)[LIVE];
+    }
+
+    /**
+     * Number of native objects of each native class, one line per class.
+     */
+    public static native String objectReport();
+
+    private static native long[] objectCounts(String className);
 }
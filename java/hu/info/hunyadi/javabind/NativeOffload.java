@@ -0,0 +1,112 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+package hu.info.hunyadi.javabind;
+
+import java.lang.invoke.MethodHandle;
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.MethodType;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * Runs native calls made from virtual threads on a dedicated pool of platform
+ * threads.
+ *
+ * A native call cannot be suspended, and pins the carrier thread of a virtual
+ * thread for the duration of the call. Native functions bound with the option
+ * offload are invoked through this class: on a virtual thread, the call runs on
+ * a platform thread while the virtual thread is parked; on a platform thread,
+ * the call runs directly.
+ */
+public final class NativeOffload {
+    private NativeOffload() {
+    }
+
+    /**
+     * Checks whether a thread is virtual, or null if the Java runtime has no
+     * virtual threads.
+     */
+    private static final MethodHandle isVirtual = findIsVirtual();
+
+    private static final AtomicInteger threadCount = new AtomicInteger();
+
+    private static final ExecutorService executor = Executors.newCachedThreadPool(runnable -> {
+        Thread thread = new Thread(runnable, "javabind-offload-" + threadCount.incrementAndGet());
+        thread.setDaemon(true);
+        return thread;
+    });
+
+    private static MethodHandle findIsVirtual() {
+        try {
+            return MethodHandles.publicLookup().findVirtual(Thread.class, "isVirtual",
+                    MethodType.methodType(boolean.class));
+        } catch (ReflectiveOperationException e) {
+            return null;
+        }
+    }
+
+    private static boolean isVirtualThread() {
+        if (isVirtual == null) {
+            return false;
+        }
+        try {
+            return (boolean) isVirtual.invokeExact(Thread.currentThread());
+        } catch (Throwable e) {
+            return false;
+        }
+    }
+
+    /**
+     * Invokes a native function that returns a value.
+     */
+    public static <T> T call(Callable<T> task) {
+        try {
+            if (!isVirtualThread()) {
+                return task.call();
+            }
+            Future<T> future = executor.submit(task);
+            try {
+                return future.get();
+            } catch (InterruptedException e) {
+                future.cancel(false);
+                Thread.currentThread().interrupt();
+                throw new IllegalStateException("Interrupted while waiting for native call", e);
+            }
+        } catch (ExecutionException e) {
+            throw NativeOffload.<RuntimeException>rethrow(e.getCause());
+        } catch (Exception e) {
+            throw NativeOffload.<RuntimeException>rethrow(e);
+        }
+    }
+
+    /**
+     * Invokes a native function that returns no value.
+     */
+    public static void run(Runnable task) {
+        call(() -> {
+            task.run();
+            return null;
+        });
+    }
+
+    /**
+     * Re-throws the exception raised by the native function, which may be a
+     * checked exception not declared by the caller.
+     */
+    @SuppressWarnings("unchecked")
+    private static <E extends Throwable> E rethrow(Throwable e) throws E {
+        throw (E) e;
+    }
+}
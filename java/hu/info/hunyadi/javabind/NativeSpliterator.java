@@ -0,0 +1,127 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+package hu.info.hunyadi.javabind;
+
+import java.util.Spliterator;
+import java.util.function.Consumer;
+
+/**
+ * Traverses a sequence of elements that reside in the native code execution
+ * context, fetching elements in batches.
+ */
+public final class NativeSpliterator<T> extends NativeCallback implements Spliterator<T> {
+    private final long pointer;
+    private final int batchSize;
+    private final int characteristics;
+
+    private Object[] buffer;
+    private int index;
+    private boolean exhausted;
+
+    protected NativeSpliterator(long pointer, int batchSize, int characteristics) {
+        super(pointer);
+        this.pointer = pointer;
+        this.batchSize = batchSize;
+        this.characteristics = characteristics;
+    }
+
+    /**
+     * Ensures that the buffer has at least one element to consume.
+     */
+    private boolean fill() {
+        if (buffer != null && index < buffer.length) {
+            return true;
+        }
+        if (exhausted) {
+            return false;
+        }
+        buffer = fetch(pointer, batchSize);
+        index = 0;
+        if (buffer == null || buffer.length == 0) {
+            buffer = null;
+            exhausted = true;
+            return false;
+        }
+        return true;
+    }
+
+    @SuppressWarnings("unchecked")
+    @Override
+    public boolean tryAdvance(Consumer<? super T> action) {
+        if (!fill()) {
+            return false;
+        }
+        T item = (T) buffer[index];
+        buffer[index++] = null;
+        action.accept(item);
+        return true;
+    }
+
+    @SuppressWarnings("unchecked")
+    @Override
+    public void forEachRemaining(Consumer<? super T> action) {
+        while (fill()) {
+            Object[] items = buffer;
+            int end = items.length;
+            for (; index < end; ++index) {
+                T item = (T) items[index];
+                items[index] = null;
+                action.accept(item);
+            }
+        }
+    }
+
+    @Override
+    public Spliterator<T> trySplit() {
+        // elements already fetched precede any elements that could be split off
+        if (exhausted || (buffer != null && index < buffer.length)) {
+            return null;
+        }
+        long prefix = split(pointer);
+        if (prefix == 0) {
+            return null;
+        }
+        return new NativeSpliterator<T>(prefix, batchSize, characteristics);
+    }
+
+    @Override
+    public long estimateSize() {
+        long buffered = buffer != null ? buffer.length - index : 0;
+        if (exhausted) {
+            return buffered;
+        }
+        long size = remaining(pointer);
+        return size == Long.MAX_VALUE ? size : size + buffered;
+    }
+
+    @Override
+    public int characteristics() {
+        return characteristics;
+    }
+
+    /**
+     * Returns the next batch of at most the given number of elements, or null if
+     * the sequence has been exhausted.
+     */
+    private static native Object[] fetch(long pointer, int count);
+
+    /**
+     * Splits off a prefix of the remaining elements, returning a new native
+     * pointer, or zero if the sequence cannot be split.
+     */
+    private static native long split(long pointer);
+
+    /**
+     * Returns the number of elements not yet fetched, or Long.MAX_VALUE if
+     * unknown.
+     */
+    private static native long remaining(long pointer);
+}
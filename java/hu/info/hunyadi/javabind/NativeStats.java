@@ -0,0 +1,138 @@
+/**
+ * javabind: effective C++ and Java interoperability
+ * @see https://github.com/hunyadi/javabind
+ *
+ * Copyright (c) 2024 Levente Hunyadi
+ *
+ * This work is licensed under the terms of the MIT license.
+ * For a copy, see <https://opensource.org/licenses/MIT>.
+ */
+
+package hu.info.hunyadi.javabind;
+
+/**
+ * Call counters and latency percentiles of native functions, collected when
+ * the extension module is compiled with JAVABIND_STATISTICS.
+ *
+ * Bindings are identified by their index in the array returned by
+ * {@link #names()}, in the form "fully.qualified.Class.method".
+ *
+ * When compiled with JAVABIND_JNI_ACCOUNTING, the extension module also counts
+ * calls to JNI functions on behalf of each binding and type converter. When
+ * compiled with JAVABIND_LOCAL_REF_TRACKING, it tracks local references held
+ * during each call. When compiled with JAVABIND_PAYLOAD_PROFILING, it records
+ * the size of arguments and results in a sample of calls.
+ */
+public final class NativeStats {
+    private NativeStats() {
+    }
+
+    /** Index of the number of calls in the array returned by {@link #counters(int)}. */
+    public static final int CALLS = 0;
+    /** Index of the number of calls that raised an exception. */
+    public static final int EXCEPTIONS = 1;
+    /** Index of the total time spent converting arguments, in nanoseconds. */
+    public static final int ARGUMENT_NANOS = 2;
+    /** Index of the total time spent in native function bodies, in nanoseconds. */
+    public static final int BODY_NANOS = 3;
+    /** Index of the total time spent converting results, in nanoseconds. */
+    public static final int RESULT_NANOS = 4;
+
+    /** True if the extension module collects call statistics. */
+    public static native boolean enabled();
+
+    /** Names of native function bindings. */
+    public static native String[] names();
+
+    /** Counters of a native function binding, indexed by CALLS, EXCEPTIONS, etc. */
+    public static native long[] counters(int index);
+
+    /** Upper bound on the given quantile (e.g. 0.99) of call latency, in nanoseconds. */
+    public static native long percentile(int index, double quantile);
+
+    /** Sets all counters to zero, including JNI call counts and payload sizes. */
+    public static native void reset();
+
+    /** True if the extension module counts JNI calls. */
+    public static native boolean jniCallsEnabled();
+
+    /**
+     * Number of calls to each JNI function, one line per binding and type
+     * converter, or an empty string if JNI calls are not counted.
+     */
+    public static native String jniCalls();
+
+    /**
+     * Number of calls to a JNI function (e.g. "FindClass") made on behalf of a
+     * binding, or zero if JNI calls are not counted.
+     */
+    public static native long jniCallCount(String binding, String function);
+
+    /** True if the extension module tracks local references. */
+    public static native boolean localRefsEnabled();
+
+    /**
+     * High-water mark of local references and number of leaked references, one
+     * line per binding, or an empty string if local references are not tracked.
+     */
+    public static native String localRefs();
+
+    /**
+     * Number of calls, the largest number of local references alive at the same
+     * time in a call, and the total number of local references alive on return
+     * for a binding, or zeros if local references are not tracked.
+     */
+    public static native long[] localRefCounts(String binding);
+
+    /**
+     * Sizes of arguments and results in sampled calls, one line per binding,
+     * direction and payload kind, or an empty string if sizes are not recorded.
+     */
+    public static native String payloadSizes();
+
+    /**
+     * Histogram of the sizes of arguments or results of a binding in sampled
+     * calls, where kind is one of "string_bytes", "array_length",
+     * "collection_size" or "record_count". Element 0 counts empty values, and
+     * element k counts sizes from 2^(k-1) up to but not including 2^k. All
+     * counts are zero if sizes are not recorded.
+     */
+    public static native long[] payloadHistogram(String binding, boolean result, String kind);
+
+    /**
+     * Sets the average number of calls per sampled call; 1 samples every call.
+     */
+    public static native void setPayloadSampleInterval(int interval);
+
+    /**
+     * Formats statistics of native functions that have been called, one line per
+     * function, ordered by total time spent.
+     */
+    public static String report() {
+        String[] names = names();
+        long[][] counters = new long[names.length][];
+        Integer[] order = new Integer[names.length];
+        for (int i = 0; i < names.length; ++i) {
+            counters[i] = counters(i);
+            order[i] = i;
+        }
+        java.util.Arrays.sort(order, (a, b) -> Long.compare(total(counters[b]), total(counters[a])));
+
+        StringBuilder sb = new StringBuilder();
+        for (int i : order) {
+            long[] c = counters[i];
+            if (c[CALLS] == 0) {
+                continue;
+            }
+            sb.append(String.format(
+                    "%s: calls=%d exceptions=%d args=%dns body=%dns result=%dns p50=%dns p99=%dns%n",
+                    names[i], c[CALLS], c[EXCEPTIONS], c[ARGUMENT_NANOS], c[BODY_NANOS], c[RESULT_NANOS],
+                    percentile(i, 0.5), percentile(i, 0.99)));
+        }
+        return sb.toString();
+    }
+
+    private static long total(long[] c) {
+        return c[ARGUMENT_NANOS] + c[BODY_NANOS] + c[RESULT_NANOS];
+    }
+}
@@ -18,4 +18,6 @@ public class Sample extends NativeObject {
     public native int value();
 
     public native void add(int value);
+
+    public native Sample duplicate();
 }
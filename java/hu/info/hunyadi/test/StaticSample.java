@@ -1,8 +1,12 @@
 package hu.info.hunyadi.test;
 
+import hu.info.hunyadi.javabind.NativeCallEvent;
+import hu.info.hunyadi.javabind.NativeOffload;
+
 import java.util.List;
 import java.util.Set;
 import java.util.Map;
+import java.util.concurrent.CompletableFuture;
 import java.util.function.Predicate;
 import java.util.function.IntPredicate;
 import java.util.function.LongPredicate;
@@ -118,10 +122,85 @@ public class StaticSample {
 
     public static native double[] pass_double_array_view(double[] values);
 
+    public static native double parallel_sum_view(double[] values);
+
+    public static native double parallel_sum_pinned(double[] values);
+
+    public static native double parallel_sum_busy_workers(double[] values);
+
+    public static native String[] pass_string_array(String[] values);
+
+    public static native Rectangle[] pass_record_array(Rectangle[] values);
+
+    public static native String[] generate_string_array(int count);
+
+    public static native Rectangle[] generate_record_array(int count);
+
+    public static native double[][] pass_nested_double_array(double[][] values);
+
+    public static native int[][] transpose_int_matrix(int[][] values);
+
+    public static native double[][] transpose_double_matrix(double[][] values);
+
     public static native String pass_function(String s, Function<String, String> fn);
 
     public static native Function<String, String> returns_function(String search, String replace);
 
+    public static native String apply_on_executor(String s, Function<String, String> fn);
+
+    public static native long release_on_native_thread(Function<String, String> fn);
+
+    public static native long pending_releases();
+
+    public static native long[] global_ref_handles(String s);
+
+    public static native void leak_local_refs(int count);
+
+    public static native String dispatch_from_native_thread(String s, Function<String, String> fn);
+
+    public static native void post_from_native_thread(int count, IntConsumer fn);
+
+    public static native CompletableFuture<String> repeat_async(String s, int count);
+
+    public static String repeat_offloaded(String s, int count) {
+        return NativeOffload.call(() -> repeat_offloaded$native(s, count));
+    }
+
+    private static native String repeat_offloaded$native(String s, int count);
+
+    public static String pass_function_offloaded(String s, Function<String, String> fn) {
+        return NativeOffload.call(() -> pass_function_offloaded$native(s, fn));
+    }
+
+    private static native String pass_function_offloaded$native(String s, Function<String, String> fn);
+
+    public static void apply_string_consumer_offloaded(String value, Consumer<String> fn) {
+        NativeOffload.run(() -> apply_string_consumer_offloaded$native(value, fn));
+    }
+
+    private static native void apply_string_consumer_offloaded$native(String value, Consumer<String> fn);
+
+    public static String repeat_traced(String s, int count) {
+        NativeCallEvent event = new NativeCallEvent();
+        event.begin();
+        try {
+            return repeat_traced$native(s, count);
+        } finally {
+            event.end();
+            if (event.shouldCommit()) {
+                event.binding = StaticSample.class.getName() + ".repeat_traced";
+                event.argumentSize = NativeCallEvent.sizeOf(s, count);
+                event.commit();
+            }
+        }
+    }
+
+    private static native String repeat_traced$native(String s, int count);
+
+    public static native List<String> get_startup_timings();
+
+    public static native CompletableFuture<Integer> pass_int_async(int value);
+
     public static native void apply_int_consumer(int value, IntConsumer fn);
 
     public static native void apply_long_consumer(long value, LongConsumer fn);
@@ -130,6 +209,14 @@ public class StaticSample {
 
     public static native void apply_string_consumer(String value, Consumer<String> fn);
 
+    public static native int count_matching(String[] items, Predicate<String> pred);
+
+    public static native String[] sort_by_key(String[] items, ToLongFunction<String> key);
+
+    public static native void emit_int_batches(int count, Consumer<Integer> fn);
+
+    public static native void emit_string_batches(int count, Consumer<String> fn);
+
     public static native boolean apply_int_predicate(int value, IntPredicate fn);
 
     public static native boolean apply_long_predicate(long value, LongPredicate fn);
@@ -212,6 +299,12 @@ public class StaticSample {
     public static native java.util.Map<java.lang.Integer, String> pass_unordered_map_with_boxed_key_and_hash(
             java.util.Map<java.lang.Integer, String> map);
 
+    public static native java.util.stream.Stream<java.lang.Integer> get_int_stream(int count);
+
+    public static native java.util.stream.Stream<java.lang.Integer> get_int_stream_batched(int count, long batch_size);
+
+    public static native java.util.stream.Stream<String> get_string_stream(int count);
+
     public static native Rectangle pass_optional_rectangle(Rectangle rectangle);
 
     public static native Integer pass_optional_int(Integer i);
@@ -1,14 +1,31 @@
 package hu.info.hunyadi.test;
 
+import hu.info.hunyadi.javabind.NativeObject;
+import hu.info.hunyadi.javabind.NativeStats;
+import java.io.IOException;
+import java.io.UncheckedIOException;
+import java.lang.ref.WeakReference;
+import java.nio.file.Files;
+import java.nio.file.Path;
 import java.util.Arrays;
 import java.util.function.Function;
 import java.util.List;
 import java.util.Set;
 import java.util.Map;
+import java.util.concurrent.CompletionException;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.stream.Collectors;
+import java.util.stream.IntStream;
 
 import java.time.Duration;
 import java.time.Instant;
 
+import jdk.jfr.Recording;
+import jdk.jfr.consumer.RecordedEvent;
+import jdk.jfr.consumer.RecordingFile;
+
 public class TestJavaBind {
     public static String string_transform(String source) {
         return source.replace(' ', '_');
@@ -23,11 +40,68 @@ public class TestJavaBind {
         }
     }
 
+    /**
+     * Requests garbage collection until the referenced object is collected, or gives up after several attempts.
+     */
+    public static boolean isCollected(WeakReference<?> ref) {
+        for (int i = 0; i < 100 && ref.get() != null; ++i) {
+            System.gc();
+            try {
+                Thread.sleep(10);
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+                break;
+            }
+        }
+        return ref.get() == null;
+    }
+
+    /**
+     * Creates an executor that starts a virtual thread for each task, or returns null if the Java runtime has no
+     * virtual threads.
+     */
+    public static ExecutorService newVirtualThreadExecutor() {
+        try {
+            return (ExecutorService) Executors.class.getMethod("newVirtualThreadPerTaskExecutor").invoke(null);
+        } catch (ReflectiveOperationException e) {
+            return null;
+        }
+    }
+
+    /**
+     * Calls a traced native function during a flight recording, and returns the events of the call.
+     */
+    public static List<RecordedEvent> recordNativeCallEvents(Runnable runnable) {
+        try (Recording recording = new Recording()) {
+            recording.enable("hu.info.hunyadi.javabind.NativeCall");
+            recording.start();
+            runnable.run();
+            recording.stop();
+            Path path = Files.createTempFile("javabind", ".jfr");
+            try {
+                recording.dump(path);
+                return RecordingFile.readAllEvents(path);
+            } finally {
+                Files.delete(path);
+            }
+        } catch (IOException e) {
+            throw new UncheckedIOException(e);
+        }
+    }
+
     public static void main(String[] args) {
         System.out.println("LOAD: Java host application");
         System.loadLibrary("javabind_native");
         System.out.println("LOAD: native library");
 
+        List<String> startup = StaticSample.get_startup_timings();
+        assert startup.contains("initializer:");
+        assert startup.contains("callback_registry:");
+        assert startup.contains("function_registration:hu.info.hunyadi.test.Sample");
+        assert startup.contains("record_validation:hu.info.hunyadi.test.Rectangle");
+        assert startup.contains("enum_initialization:hu.info.hunyadi.test.FooBar");
+        System.out.println("PASS: startup profile");
+
         StaticSample.returns_void();
         assert StaticSample.returns_bool();
         assert StaticSample.returns_int() == 82;
@@ -115,9 +189,118 @@ public class TestJavaBind {
         assert Arrays.equals(StaticSample.pass_double_array_view(double_array), double_array);
         assertThrowsNullPointerException(() -> StaticSample.pass_bool_array(null));
         assertThrowsNullPointerException(() -> StaticSample.pass_int_array(null));
+        String[] string_array = new String[] { "one", "two", "three" };
+        Rectangle[] record_array = new Rectangle[] { new Rectangle(1.0, 2.0), new Rectangle(3.0, 4.0) };
+        assert Arrays.equals(StaticSample.pass_string_array(string_array), string_array);
+        assert Arrays.equals(StaticSample.pass_record_array(record_array), record_array);
+        assert StaticSample.pass_string_array(new String[0]).length == 0;
+        assertThrowsNullPointerException(() -> StaticSample.pass_string_array(null));
+        assertThrowsNullPointerException(() -> StaticSample.pass_string_array(new String[] { "one", null }));
+        double[][] jagged_array = new double[][] { { 1.0 }, { 2.0, 3.0 }, {} };
+        assert Arrays.deepEquals(StaticSample.pass_nested_double_array(jagged_array), jagged_array);
+        int[][] int_matrix = new int[][] { { 1, 2, 3 }, { 4, 5, 6 } };
+        assert Arrays.deepEquals(StaticSample.transpose_int_matrix(int_matrix),
+                new int[][] { { 1, 4 }, { 2, 5 }, { 3, 6 } });
+        double[][] double_matrix = new double[][] { { 1.0, 0.5 }, { 0.25, 0.125 } };
+        assert Arrays.deepEquals(StaticSample.transpose_double_matrix(double_matrix),
+                new double[][] { { 1.0, 0.25 }, { 0.5, 0.125 } });
+        assert StaticSample.transpose_double_matrix(new double[0][]).length == 0;
+        assertThrowsNullPointerException(() -> StaticSample.transpose_double_matrix(null));
+        assertThrowsNullPointerException(() -> StaticSample.transpose_double_matrix(new double[][] { { 1.0 }, null }));
+        double[] summands = new double[100000];
+        Arrays.fill(summands, 0.5);
+        assert StaticSample.parallel_sum_view(summands) == 50000.0;
+        assert StaticSample.parallel_sum_pinned(summands) == 50000.0;
+        assert StaticSample.parallel_sum_pinned(new double[0]) == 0.0;
+        assert StaticSample.parallel_sum_busy_workers(summands) == 50000.0;
+        String[] generated = StaticSample.generate_string_array(100000);
+        assert generated.length == 100000;
+        for (int i = 0; i < generated.length; ++i) {
+            assert generated[i].equals(String.valueOf(i));
+        }
+        Rectangle[] generated_records = StaticSample.generate_record_array(100000);
+        assert generated_records.length == 100000;
+        for (int i = 0; i < generated_records.length; ++i) {
+            assert generated_records[i].equals(new Rectangle(i, 2.0 * i));
+        }
         System.out.println("PASS: class functions with array types");
 
         assert StaticSample.pass_function("my string", s -> "'" + s + "'").equals("my string -> 'my string'");
+        String worker = StaticSample.apply_on_executor("thread",
+                s -> s + ":" + Thread.currentThread().getName() + ":" + Thread.currentThread().isDaemon());
+        assert worker.startsWith("thread:javabind-worker-") && worker.endsWith(":true");
+        Function<String, String> released = s -> s + worker;
+        WeakReference<Function<String, String>> releasedRef = new WeakReference<>(released);
+        assert StaticSample.release_on_native_thread(released) >= 1;
+        released = null;
+        try (Sample sample = Sample.create()) {
+            // creating and closing a native object releases deferred references
+        }
+        assert isCollected(releasedRef);
+        assert StaticSample.pending_releases() == 0;
+        // a unique handle, followed by shared handles with atomic and with single-threaded reference counting
+        assert Arrays.equals(StaticSample.global_ref_handles("handle"),
+                new long[] { 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 0, 1 });
+        String dispatched = StaticSample.dispatch_from_native_thread("thread",
+                s -> s + ":" + Thread.currentThread().getName());
+        assert dispatched.equals("thread:javabind-dispatcher");
+        List<Integer> posted = new java.util.ArrayList<>();
+        StaticSample.post_from_native_thread(10, posted::add);
+        assert posted.equals(IntStream.range(0, 10).boxed().collect(Collectors.toList()));
+        assert StaticSample.repeat_async("ab", 3).join().equals("ababab");
+        assert StaticSample.repeat_offloaded("ab", 2).equals("abab");
+        try {
+            StaticSample.repeat_offloaded("ab", -1);
+            assert false;
+        } catch (Exception e) {
+            assert e.getMessage().equals("count must not be negative");
+        }
+        ExecutorService virtualThreads = newVirtualThreadExecutor();
+        if (virtualThreads != null) {
+            try {
+                assert virtualThreads.submit(() -> StaticSample.repeat_offloaded("ab", 2)).get().equals("abab");
+                String offloaded = virtualThreads.submit(() -> StaticSample.pass_function_offloaded("thread",
+                        s -> Thread.currentThread().getName())).get();
+                assert offloaded.startsWith("thread -> javabind-offload-");
+                List<String> consumed = new java.util.ArrayList<>();
+                virtualThreads.submit(() -> StaticSample.apply_string_consumer_offloaded("thread",
+                        s -> consumed.add(s + ":" + Thread.currentThread().getName()))).get();
+                assert consumed.size() == 1 && consumed.get(0).startsWith("thread:javabind-offload-");
+                try {
+                    virtualThreads.submit(() -> StaticSample.repeat_offloaded("ab", -1)).get();
+                    assert false;
+                } catch (ExecutionException e) {
+                    assert e.getCause().getMessage().equals("count must not be negative");
+                }
+                try {
+                    virtualThreads.submit(() -> StaticSample.apply_string_consumer_offloaded("thread", s -> {
+                        throw new IllegalStateException("rejected");
+                    })).get();
+                    assert false;
+                } catch (ExecutionException e) {
+                    assert e.getCause() instanceof IllegalStateException;
+                    assert e.getCause().getMessage().equals("rejected");
+                }
+            } catch (InterruptedException | ExecutionException e) {
+                throw new IllegalStateException(e);
+            } finally {
+                virtualThreads.shutdown();
+            }
+            System.out.println("PASS: offloaded functions called from virtual threads");
+        }
+        List<RecordedEvent> events = recordNativeCallEvents(() -> {
+            assert StaticSample.repeat_traced("ab", 3).equals("ababab");
+        });
+        assert events.size() == 1;
+        assert events.get(0).getString("binding").equals("hu.info.hunyadi.test.StaticSample.repeat_traced");
+        assert events.get(0).getLong("argumentSize") == 2;
+        assert StaticSample.pass_int_async(42).join() == 42;
+        try {
+            StaticSample.repeat_async("ab", -1).join();
+            assert false;
+        } catch (CompletionException e) {
+            assert e.getCause().getMessage().equals("count must not be negative");
+        }
         Function<String, String> replace = StaticSample.returns_function(" ", "_");
         assert replace.apply("my string").equals("my_string");
         assert replace.apply("lorem ipsum dolor sit amet").equals("lorem_ipsum_dolor_sit_amet");
@@ -127,6 +310,24 @@ public class TestJavaBind {
         StaticSample.apply_double_consumer(3.14159265359, val -> System.out.println(val));
         StaticSample.apply_string_consumer("start to finish", val -> System.out.println(val));
         assertThrowsNullPointerException(() -> StaticSample.apply_int_consumer(23, null));
+        assert StaticSample.count_matching(new String[] { "apple", "avocado", "banana" }, s -> s.startsWith("a")) == 2;
+        assert Arrays.equals(StaticSample.sort_by_key(new String[] { "ccc", "a", "bb" }, s -> (long) s.length()),
+                new String[] { "a", "bb", "ccc" });
+        List<Integer> int_batches = new java.util.ArrayList<>();
+        StaticSample.emit_int_batches(1000, int_batches::add);
+        assert int_batches.equals(IntStream.range(0, 1000).boxed().collect(Collectors.toList()));
+        List<String> string_batches = new java.util.ArrayList<>();
+        StaticSample.emit_string_batches(100, string_batches::add);
+        assert string_batches.size() == 100 && string_batches.get(99).equals("99");
+        assertThrowsNullPointerException(() -> StaticSample.emit_int_batches(1, null));
+        try {
+            StaticSample.emit_int_batches(10, value -> {
+                throw new IllegalStateException("rejected");
+            });
+            assert false;
+        } catch (IllegalStateException e) {
+            assert e.getMessage().equals("rejected");
+        }
 
         assert StaticSample.apply_int_predicate(23, val -> val > 0);
         assert StaticSample.apply_long_predicate(1989l, val -> val > 0l);
@@ -169,7 +370,9 @@ public class TestJavaBind {
         assertThrowsNullPointerException(() -> StaticSample.pass_record(null));
         System.out.println("PASS: record class");
 
+        long liveSamples = NativeObject.liveObjects(Sample.class);
         try (Sample obj = Sample.create()) {
+            assert NativeObject.liveObjects(Sample.class) == liveSamples + 1;
             obj.returns_void();
             assert obj.returns_bool();
             assert obj.returns_int() == 82;
@@ -179,7 +382,15 @@ public class TestJavaBind {
             assert obj.value() == 10;
             obj.add(13);
             assert obj.value() == 23;
+
+            try (Sample copy = obj.duplicate()) {
+                assert copy.value() == 23;
+                assert NativeObject.liveObjects(Sample.class) == liveSamples + 2;
+            }
+            assert NativeObject.liveObjects(Sample.class) == liveSamples + 1;
         }
+        assert NativeObject.liveObjects(Sample.class) == liveSamples;
+        assert NativeObject.objectCounts(Sample.class)[NativeObject.CREATED] == NativeObject.objectCounts(Sample.class)[NativeObject.DESTROYED] + liveSamples;
         System.out.println("PASS: class constructor and member functions");
 
         Residence budapest = new Residence("Hungary", "Budapest");
@@ -216,6 +427,14 @@ public class TestJavaBind {
                 .equals(Map.of(1, "one", 2, "two", 3, "three"));
         assert StaticSample.pass_ordered_map_with_int_value(Map.of("one", 1, "two", 2, "three", 3))
                 .equals(Map.of("one", 1, "two", 2, "three", 3));
+        List<Rectangle> largeList = IntStream.range(0, 5000).mapToObj(i -> new Rectangle(i, 2.0 * i))
+                .collect(Collectors.toList());
+        assert StaticSample.pass_list(largeList).equals(largeList);
+        Set<Integer> largeSet = IntStream.range(0, 1000).boxed().collect(Collectors.toSet());
+        assert StaticSample.pass_ordered_set_with_int_key(largeSet).equals(largeSet);
+        Map<Integer, String> largeMap = IntStream.range(0, 600).boxed()
+                .collect(Collectors.toMap(i -> i, i -> Integer.toString(i)));
+        assert StaticSample.pass_ordered_map_with_int_key(largeMap).equals(largeMap);
         assertThrowsNullPointerException(() -> StaticSample.pass_list(null));
         assertThrowsNullPointerException(() -> StaticSample.pass_ordered_set(null));
         assertThrowsNullPointerException(() -> StaticSample.pass_unordered_set(null));
@@ -223,6 +442,25 @@ public class TestJavaBind {
         assertThrowsNullPointerException(() -> StaticSample.pass_unordered_map(null));
         System.out.println("PASS: collections");
 
+        assert StaticSample.get_int_stream(0).count() == 0;
+        assert StaticSample.get_int_stream(100).mapToInt(Integer::intValue).sum() == 4950;
+        assert StaticSample.get_int_stream(1000).parallel().mapToLong(Integer::longValue).sum() == 499500;
+        assert StaticSample.get_int_stream(1000).parallel().collect(Collectors.toList())
+                .equals(IntStream.range(0, 1000).boxed().collect(Collectors.toList()));
+        assert StaticSample.get_int_stream_batched(10, 1).count() == 10;
+        for (long batchSize : new long[] { 0, (long) Integer.MAX_VALUE + 1 }) {
+            try {
+                StaticSample.get_int_stream_batched(10, batchSize);
+                assert false;
+            } catch (Exception e) {
+                assert e.getMessage().startsWith("Stream batch size ");
+            }
+        }
+        assert StaticSample.get_string_stream(40).skip(35).collect(Collectors.toList())
+                .equals(List.of("35", "36", "37", "38", "39"));
+        assert StaticSample.get_string_stream(1000).anyMatch(s -> s.equals("20"));
+        System.out.println("PASS: streams");
+
         assert StaticSample.pass_optional_rectangle(null) == null;
         assert StaticSample.pass_optional_rectangle(new Rectangle(1.0, 2.0)).equals(new Rectangle(1.0, 2.0));
         assert StaticSample.pass_optional_int(null) == null;
@@ -231,5 +469,53 @@ public class TestJavaBind {
         assert StaticSample.pass_optional_string("ok").equals("ok");
         System.out.println("PASS: optional");
 
+        if (NativeStats.enabled()) {
+            NativeStats.reset();
+            StaticSample.pass_int(1);
+            StaticSample.pass_int(2);
+            int index = Arrays.asList(NativeStats.names()).indexOf("hu.info.hunyadi.test.StaticSample.pass_int");
+            assert index >= 0;
+            assert NativeStats.counters(index)[NativeStats.CALLS] == 2;
+            assert NativeStats.counters(index)[NativeStats.EXCEPTIONS] == 0;
+            assert NativeStats.percentile(index, 0.99) >= NativeStats.percentile(index, 0.5);
+            System.out.println("PASS: statistics");
+        }
+
+        if (NativeStats.jniCallsEnabled()) {
+            NativeStats.reset();
+            StaticSample.pass_string("alma");
+            assert NativeStats.jniCallCount("hu.info.hunyadi.test.StaticSample.pass_string", "GetStringUTFRegion") == 1;
+            StaticSample.parallel_sum_view(new double[] { 1.0, 2.0 });
+            String binding = "hu.info.hunyadi.test.StaticSample.parallel_sum_view";
+            assert NativeStats.jniCallCount(binding, "GetPrimitiveArrayCritical") == 1;
+            assert NativeStats.jniCallCount(binding, "FindClass") == 0;
+            assert NativeStats.jniCallCount(binding, "GetMethodID") == 0;
+            assert StaticSample.get_int_stream(10).mapToInt(Integer::intValue).sum() == 45;
+            assert NativeStats.jniCallCount("hu.info.hunyadi.javabind.NativeSpliterator.fetch", "NewObjectArray") >= 1;
+            System.out.println("PASS: JNI call accounting");
+        }
+
+        if (NativeStats.localRefsEnabled()) {
+            NativeStats.reset();
+            StaticSample.pass_list(List.of(new Rectangle(1.0, 2.0), new Rectangle(3.0, 4.0)));
+            long[] counts = NativeStats.localRefCounts("hu.info.hunyadi.test.StaticSample.pass_list");
+            assert counts[0] == 1 && counts[1] > 0 && counts[2] == 0;
+            StaticSample.leak_local_refs(3);
+            counts = NativeStats.localRefCounts("hu.info.hunyadi.test.StaticSample.leak_local_refs");
+            assert counts[0] == 1 && counts[1] == 3 && counts[2] == 3;
+            System.out.println("PASS: local reference tracking");
+        }
+
+        NativeStats.reset();
+        NativeStats.setPayloadSampleInterval(1);
+        StaticSample.pass_list(List.of(new Rectangle(1.0, 2.0), new Rectangle(3.0, 4.0)));
+        long[] sizes = NativeStats.payloadHistogram("hu.info.hunyadi.test.StaticSample.pass_list", false, "collection_size");
+        assert sizes.length == 65;
+        if (!NativeStats.payloadSizes().isEmpty()) {
+            assert sizes[2] == 1;  // a size of 2 falls in the range [2, 4)
+            assert NativeStats.payloadHistogram("hu.info.hunyadi.test.StaticSample.pass_list", false, "record_count")[2] == 1;
+        }
+        System.out.println("PASS: payload sizes");
+
     }
 }
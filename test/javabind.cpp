@@ -9,8 +9,12 @@
  */
 
 #include <javabind/javabind.hpp>
+#include <atomic>
 #include <charconv>
+#include <future>
+#include <numeric>
 #include <optional>
+#include <thread>
 #include <vector>
 #include <javabind/codegen.hpp>
 #include "format.hpp"
@@ -73,6 +77,11 @@ struct Sample
         _value += val;
     }
 
+    Sample duplicate() const
+    {
+        return *this;
+    }
+
 private:
     int32_t _value = 0;
 };
@@ -195,12 +204,228 @@ struct StaticSample
         return result;
     }
 
+    static double parallel_sum_view(const std::basic_string_view<double>& values)
+    {
+        auto sums = javabind::parallel_for_view(values, [](std::basic_string_view<double> part, std::size_t) {
+            return std::accumulate(part.begin(), part.end(), 0.0);
+        }, 1000);
+        return std::accumulate(sums.begin(), sums.end(), 0.0);
+    }
+
+    static double parallel_sum_pinned(const javabind::pinned_array<double>& values)
+    {
+        auto sums = javabind::parallel_for_view(values, [](std::basic_string_view<double> part, std::size_t) {
+            return std::accumulate(part.begin(), part.end(), 0.0);
+        }, 1000);
+        double sum = std::accumulate(sums.begin(), sums.end(), 0.0);
+        JAVA_OUTPUT << "parallel_sum_pinned(" << values.size() << ") = " << sum << std::endl;  // array is no longer pinned
+        return sum;
+    }
+
+    /**
+     * Sums values while every worker of the shared executor is busy, such that all partitions run on the calling thread.
+     */
+    static double parallel_sum_busy_workers(const javabind::pinned_array<double>& values)
+    {
+        javabind::executor& pool = javabind::executor::shared();
+        std::atomic<std::size_t> started = 0;
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        std::vector<std::future<void>> busy;
+        for (std::size_t i = 0; i < pool.size(); ++i) {
+            busy.push_back(pool.submit([&started, released]() {
+                started.fetch_add(1);
+                released.wait();
+            }));
+        }
+        while (started.load() < pool.size()) {
+            std::this_thread::yield();
+        }
+
+        double sum = parallel_sum_pinned(values);
+        release.set_value();
+        for (auto&& future : busy) {
+            future.wait();
+        }
+        return sum;
+    }
+
+    template <typename T>
+    static javabind::array_of<T> pass_object_array(const javabind::array_of<T>& values)
+    {
+        JAVA_OUTPUT << "pass_object_array(" << values << ")" << std::endl;
+        return javabind::array_of<T>(values.begin(), values.end());
+    }
+
+    static javabind::array_of<std::string> generate_string_array(int32_t count)
+    {
+        JAVA_OUTPUT << "generate_string_array(" << count << ")" << std::endl;
+        javabind::array_of<std::string> values;
+        values.reserve(count);
+        for (int32_t k = 0; k < count; ++k) {
+            values.push_back(std::to_string(k));
+        }
+        return values;
+    }
+
+    static javabind::array_of<Rectangle> generate_record_array(int32_t count)
+    {
+        JAVA_OUTPUT << "generate_record_array(" << count << ")" << std::endl;
+        javabind::array_of<Rectangle> values;
+        values.reserve(count);
+        for (int32_t k = 0; k < count; ++k) {
+            values.emplace_back(k, 2.0 * k);
+        }
+        return values;
+    }
+
+    template <typename T>
+    static javabind::array_of<std::vector<T>> pass_nested_array(const javabind::array_of<std::vector<T>>& values)
+    {
+        JAVA_OUTPUT << "pass_nested_array(" << values.size() << ")" << std::endl;
+        return javabind::array_of<std::vector<T>>(values.begin(), values.end());
+    }
+
+    template <typename T>
+    static javabind::matrix<T> transpose_matrix(const javabind::matrix<T>& mat)
+    {
+        JAVA_OUTPUT << "transpose_matrix(" << mat.rows() << " x " << mat.cols() << ")" << std::endl;
+        javabind::matrix<T> result(mat.cols(), mat.rows());
+        for (std::size_t r = 0; r < mat.rows(); ++r) {
+            for (std::size_t c = 0; c < mat.cols(); ++c) {
+                result(c, r) = mat(r, c);
+            }
+        }
+        return result;
+    }
+
     static std::string pass_function(const std::string& str, const std::function<std::string(std::string)>& fn)
     {
         JAVA_OUTPUT << "pass_function(" << str << ")" << std::endl;
         return str + " -> " + fn(str);
     }
 
+    static std::string apply_on_executor(const std::string& str, const std::function<std::string(std::string)>& fn)
+    {
+        JAVA_OUTPUT << "apply_on_executor(" << str << ")" << std::endl;
+        return javabind::executor::shared().submit([&str, &fn]() { return fn(str); }).get();
+    }
+
+    static int64_t release_on_native_thread(std::function<std::string(std::string)> fn)
+    {
+        JAVA_OUTPUT << "release_on_native_thread()" << std::endl;
+        bool detached = false;
+        std::thread thread([fn = std::move(fn), &detached]() mutable {
+            fn = nullptr;  // drops the last reference to the Java function object
+            detached = javabind::this_thread.peekEnv() == nullptr;
+        });
+        thread.join();
+        return detached ? static_cast<int64_t>(javabind::ReleaseQueue::pending()) : -1;
+    }
+
+    static int64_t pending_releases()
+    {
+        return static_cast<int64_t>(javabind::ReleaseQueue::pending());
+    }
+
+    /**
+     * Copies, moves and drops global reference handles to a Java string, recording whether each step has the expected
+     * effect on the owners and the lifetime of the global reference.
+     */
+    template <typename Policy>
+    static void shared_global_ref_steps(JNIEnv* env, jobject obj, std::vector<int64_t>& steps)
+    {
+        javabind::SharedGlobalRef<Policy> first(env, obj);
+        jobject ref = first.ref();
+        steps.push_back(static_cast<int64_t>(first.use_count()));
+        {
+            javabind::SharedGlobalRef<Policy> copy = first;
+            steps.push_back(copy.ref() == ref && first.use_count() == 2);
+            javabind::SharedGlobalRef<Policy> moved = std::move(copy);
+            steps.push_back(copy.ref() == nullptr && moved.use_count() == 2);
+        }
+        steps.push_back(static_cast<int64_t>(first.use_count()));
+        steps.push_back(env->GetObjectRefType(ref) == JNIGlobalRefType);
+        first = javabind::SharedGlobalRef<Policy>();
+        steps.push_back(static_cast<int64_t>(first.use_count()));
+        steps.push_back(env->GetObjectRefType(ref) == JNIInvalidRefType);
+    }
+
+    static std::vector<int64_t> global_ref_handles(const std::string& str)
+    {
+        JNIEnv* env = javabind::this_thread.getEnv();
+        javabind::LocalObjectRef obj(env, env->NewStringUTF(str.c_str()));
+        std::vector<int64_t> steps;
+
+        jobject ref;
+        {
+            javabind::UniqueGlobalRef unique(env, obj.ref());
+            ref = unique.ref();
+            javabind::UniqueGlobalRef moved(std::move(unique));
+            steps.push_back(unique.ref() == nullptr && moved.ref() == ref);
+            steps.push_back(env->GetObjectRefType(ref) == JNIGlobalRefType);
+        }
+        steps.push_back(env->GetObjectRefType(ref) == JNIInvalidRefType);
+
+        shared_global_ref_steps<javabind::atomic_ref_count>(env, obj.ref(), steps);
+        shared_global_ref_steps<javabind::local_ref_count>(env, obj.ref(), steps);
+        return steps;
+    }
+
+    /**
+     * Creates local references without deleting them, such that local reference tracking reports a leak.
+     */
+    static void leak_local_refs(int32_t count)
+    {
+        JNIEnv* env = javabind::this_thread.getEnv();
+        for (int32_t i = 0; i < count; ++i) {
+            env->NewStringUTF("leak");
+        }
+    }
+
+    static std::string dispatch_from_native_thread(const std::string& str, javabind::dispatched<std::string(std::string)> fn)
+    {
+        JAVA_OUTPUT << "dispatch_from_native_thread(" << str << ")" << std::endl;
+        std::string result;
+        std::thread thread([&]() { result = fn(str); });
+        thread.join();
+        return result;
+    }
+
+    static void post_from_native_thread(int32_t count, javabind::dispatched<void(int32_t), javabind::dispatch_policy::fire_and_forget> fn)
+    {
+        JAVA_OUTPUT << "post_from_native_thread(" << count << ")" << std::endl;
+        std::thread thread([&]() {
+            for (int32_t k = 0; k < count; ++k) {
+                fn(k);
+            }
+        });
+        thread.join();
+
+        // callbacks run in order of submission, wait for those already posted
+        javabind::dispatcher::shared().call([]() {});
+    }
+
+    /** Phases and classes measured when the extension module has been loaded, in the form "phase:class". */
+    inline static std::vector<std::string> startup_timings;
+
+    static std::vector<std::string> get_startup_timings()
+    {
+        return startup_timings;
+    }
+
+    static std::string repeat_string(const std::string& str, int32_t count)
+    {
+        if (count < 0) {
+            throw std::invalid_argument("count must not be negative");
+        }
+        std::string result;
+        for (int32_t k = 0; k < count; ++k) {
+            result += str;
+        }
+        return result;
+    }
+
     static std::function<std::string(std::string)> returns_function(const std::string& search, const std::string& replace)
     {
         return
@@ -229,6 +454,43 @@ struct StaticSample
         fn(val);
     }
 
+    static void emit_int_batches(int32_t count, javabind::batched_consumer<int32_t, 64> consumer)
+    {
+        JAVA_OUTPUT << "emit_int_batches(" << count << ")" << std::endl;
+        for (int32_t k = 0; k < count; ++k) {
+            consumer(k);
+        }
+        consumer.flush();
+    }
+
+    static void emit_string_batches(int32_t count, javabind::batched_consumer<std::string, 64> consumer)
+    {
+        JAVA_OUTPUT << "emit_string_batches(" << count << ")" << std::endl;
+        for (int32_t k = 0; k < count; ++k) {
+            consumer(std::to_string(k));
+        }
+        consumer.flush();
+    }
+
+    static int32_t count_matching(const javabind::array_of<std::string>& items, javabind::function_view<bool(std::string)> pred)
+    {
+        JAVA_OUTPUT << "count_matching(" << items.size() << ")" << std::endl;
+        int32_t count = 0;
+        for (auto&& item : items) {
+            if (pred(item)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    static javabind::array_of<std::string> sort_by_key(javabind::array_of<std::string> items, javabind::function_view<int64_t(std::string)> key)
+    {
+        JAVA_OUTPUT << "sort_by_key(" << items.size() << ")" << std::endl;
+        std::stable_sort(items.begin(), items.end(), [&key](const std::string& a, const std::string& b) { return key(a) < key(b); });
+        return items;
+    }
+
     template <typename T>
     static bool apply_predicate(T val, const std::function<bool(T)>& fn)
     {
@@ -332,6 +594,38 @@ struct StaticSample
         return C(collection.begin(), collection.end());
     }
 
+    static javabind::stream<int32_t> get_int_stream(int32_t count)
+    {
+        std::vector<int32_t> values;
+        for (int32_t i = 0; i < count; ++i) {
+            values.push_back(i);
+        }
+        return javabind::make_stream(std::move(values), 16);
+    }
+
+    static javabind::stream<int32_t> get_int_stream_batched(int32_t count, int64_t batch_size)
+    {
+        std::vector<int32_t> values;
+        for (int32_t i = 0; i < count; ++i) {
+            values.push_back(i);
+        }
+        return javabind::make_stream(std::move(values), static_cast<std::size_t>(batch_size));
+    }
+
+    static javabind::stream<std::string> get_string_stream(int32_t count)
+    {
+        return javabind::generate_stream(
+            [count, index = 0]() mutable -> std::optional<std::string>
+            {
+                if (index >= count) {
+                    return std::nullopt;
+                }
+                return std::to_string(index++);
+            },
+            16
+        );
+    }
+
     template <typename T>
     static std::optional<T> pass_optional(const std::optional<T>& opt)
     {
@@ -414,6 +708,16 @@ JAVA_EXTENSION_MODULE()
 {
     using namespace javabind;
 
+    // large object arrays are populated by several threads
+    marshalling_options::parallel_threshold = 10000;
+
+    // time spent in initialization is reported once all classes have been registered
+    startup_options::profile_handler = [](const StartupProfile& profile) {
+        for (auto&& timing : profile.timings) {
+            StaticSample::startup_timings.push_back(std::string(startup_phase_names[static_cast<std::size_t>(timing.phase)]) + ":" + timing.class_name);
+        }
+    };
+
     record_class<Rectangle>()
         .field<&Rectangle::width>("width")
         .field<&Rectangle::height>("height")
@@ -436,6 +740,7 @@ JAVA_EXTENSION_MODULE()
         .function<Sample::returns_int>("returns_int")
         .function<&Sample::value>("value")
         .function < &Sample::operator+=>("add")
+        .function<&Sample::duplicate>("duplicate")
         ;
 
     static_class<StaticSample>()
@@ -515,13 +820,43 @@ JAVA_EXTENSION_MODULE()
         .function<StaticSample::pass_array_view<float>>("pass_float_array_view")
         .function<StaticSample::pass_array_view<double>>("pass_double_array_view")
 
+        .function<StaticSample::parallel_sum_view>("parallel_sum_view")
+        .function<StaticSample::parallel_sum_pinned>("parallel_sum_pinned")
+        .function<StaticSample::parallel_sum_busy_workers>("parallel_sum_busy_workers")
+
+        .function<StaticSample::pass_object_array<std::string>>("pass_string_array")
+        .function<StaticSample::pass_object_array<Rectangle>>("pass_record_array")
+        .function<StaticSample::generate_string_array>("generate_string_array")
+        .function<StaticSample::generate_record_array>("generate_record_array")
+        .function<StaticSample::pass_nested_array<double>>("pass_nested_double_array")
+        .function<StaticSample::transpose_matrix<int32_t>>("transpose_int_matrix")
+        .function<StaticSample::transpose_matrix<double>>("transpose_double_matrix")
+
         // functional interface
         .function<StaticSample::pass_function>("pass_function")
         .function<StaticSample::returns_function>("returns_function")
+        .function<StaticSample::apply_on_executor>("apply_on_executor")
+        .function<StaticSample::release_on_native_thread>("release_on_native_thread")
+        .function<StaticSample::pending_releases>("pending_releases")
+        .function<StaticSample::global_ref_handles>("global_ref_handles")
+        .function<StaticSample::leak_local_refs>("leak_local_refs")
+        .function<StaticSample::dispatch_from_native_thread>("dispatch_from_native_thread")
+        .function<StaticSample::post_from_native_thread>("post_from_native_thread")
+        .function_async<StaticSample::repeat_string>("repeat_async")
+        .function<StaticSample::repeat_string>("repeat_offloaded", javabind::offload)
+        .function<StaticSample::pass_function>("pass_function_offloaded", javabind::offload)
+        .function<StaticSample::apply_consumer<std::string>>("apply_string_consumer_offloaded", javabind::offload)
+        .function<StaticSample::repeat_string>("repeat_traced", javabind::traced)
+        .function<StaticSample::get_startup_timings>("get_startup_timings")
+        .function_async<StaticSample::pass_value<int32_t>>("pass_int_async")
         .function<StaticSample::apply_consumer<int32_t>>("apply_int_consumer")
         .function<StaticSample::apply_consumer<int64_t>>("apply_long_consumer")
         .function<StaticSample::apply_consumer<double>>("apply_double_consumer")
         .function<StaticSample::apply_consumer<std::string>>("apply_string_consumer")
+        .function<StaticSample::count_matching>("count_matching")
+        .function<StaticSample::sort_by_key>("sort_by_key")
+        .function<StaticSample::emit_int_batches>("emit_int_batches")
+        .function<StaticSample::emit_string_batches>("emit_string_batches")
         .function<StaticSample::apply_predicate<int32_t>>("apply_int_predicate")
         .function<StaticSample::apply_predicate<int64_t>>("apply_long_predicate")
         .function<StaticSample::apply_predicate<double>>("apply_double_predicate")
@@ -567,6 +902,11 @@ JAVA_EXTENSION_MODULE()
         .function<StaticSample::pass_collection<std::unordered_map<std::string, int, MyHash<std::string>>>>("pass_unordered_map_with_hash")
         .function<StaticSample::pass_collection<std::unordered_map<int, std::string, MyHash<int>>>>("pass_unordered_map_with_boxed_key_and_hash")
 
+        // streams
+        .function<StaticSample::get_int_stream>("get_int_stream")
+        .function<StaticSample::get_int_stream_batched>("get_int_stream_batched")
+        .function<StaticSample::get_string_stream>("get_string_stream")
+
         // optional
         .function<StaticSample::pass_optional<Rectangle>>("pass_optional_rectangle")
         .function<StaticSample::pass_optional<int>>("pass_optional_int")